@@ -1,8 +1,12 @@
+import logging
+import math
 import re
 from esphome import pins
 import esphome.codegen as cg
 import esphome.config_validation as cv
+import esphome.final_validate as fv
 from esphome.components import uart, binary_sensor, time
+from esphome.core import CORE
 from esphome.const import (
     CONF_ID,
     CONF_ADDRESS,
@@ -11,33 +15,75 @@ from esphome.const import (
     CONF_UPDATE_INTERVAL,
     CONF_FLOW_CONTROL_PIN,
     CONF_TIME_ID,
+    CONF_HOST,
+    CONF_PORT,
+    CONF_RESTORE_VALUE,
+    CONF_UART_ID,
+    CONF_INDEX,
+    CONF_PLATFORM,
 )
 
+_LOGGER = logging.getLogger(__name__)
+
 CODEOWNERS = ["@latonita"]
 
-AUTO_LOAD = ["binary_sensor"]
 
-DEPENDENCIES = ["uart"]
+def AUTO_LOAD():
+    # sockets only for the gateway transport and the bridge, UART-only builds go without them
+    components = ["binary_sensor", "uart"]
+    hubs = (CORE.raw_config or {}).get(DOMAIN) or []
+    if isinstance(hubs, dict):
+        hubs = [hubs]
+    if any(uses_socket(hub) for hub in hubs if isinstance(hub, dict)):
+        components.append("socket")
+    return components
+
+
+def uses_socket(config):
+    return config.get(CONF_TRANSPORT) == TRANSPORT_TCP or CONF_BRIDGE in config
+
 
 MULTI_CONF = True
 
 DEFAULTS_MAX_SENSOR_INDEX = 12
 DEFAULTS_BAUD_RATE_HANDSHAKE = 9600
-DEFAULTS_BAUD_RATE_SESSION = 9600
-DEFAULTS_RECEIVE_TIMEOUT = "500ms"
-DEFAULTS_DELAY_BETWEEN_REQUESTS = "50ms"
 DEFAULTS_UPDATE_INTERVAL = "30s"
+DEFAULTS_BOOT_WAIT = "10s"
 
 CONF_ENERGOMERA_IEC_ID = "energomera_iec_id"
 CONF_REQUEST = "request"
 CONF_DELAY_BETWEEN_REQUESTS = "delay_between_requests"
+CONF_SESSION_BUDGET = "session_budget"
+CONF_ALIGN_TO_CLOCK = "align_to_clock"
+CONF_AUTO_TIME_SYNC = "auto_time_sync"
+CONF_STAGGER = "stagger"
+CONF_BUFFER_SIZE = "buffer_size"
+CONF_BOOT_WAIT = "boot_wait"
+CONF_READOUT = "readout"
+CONF_TRACE_SIZE = "trace_size"
+CONF_MODEL = "model"
+CONF_BRIDGE = "bridge"
+CONF_IDLE_TIMEOUT = "idle_timeout"
+CONF_MAX_SLOT = "max_slot"
+CONF_RETENTION = "retention"
 CONF_SUB_INDEX = "sub_index"
 
 CONF_INDICATOR = "indicator"
+CONF_RESTORED = "restored"
 CONF_REBOOT_AFTER_FAILURE = "reboot_after_failure"
 
 CONF_BAUD_RATE_HANDSHAKE = "baud_rate_handshake"
 
+CONF_TRANSPORT = "transport"
+CONF_LATENCY = "latency"
+TRANSPORT_UART = "uart"
+TRANSPORT_TCP = "tcp"
+DEFAULTS_TCP_LATENCY = "200ms"
+DEFAULTS_BRIDGE_IDLE_TIMEOUT = "3s"
+DEFAULTS_BRIDGE_MAX_SLOT = "30s"
+
+DOMAIN = "energomera_iec"
+
 energomera_iec_ns = cg.esphome_ns.namespace("energomera_iec")
 EnergomeraIec = energomera_iec_ns.class_(
     "EnergomeraIecComponent", cg.Component, uart.UARTDevice
@@ -45,6 +91,21 @@ EnergomeraIec = energomera_iec_ns.class_(
 
 BAUD_RATES = [300, 600, 1200, 2400, 4800, 9600, 19200]
 
+# delay_between_requests of METER_PROFILES in energomera_iec_profiles.h, keep in sync
+MODEL_DELAYS_MS = {
+    "CE102M": 150,
+    "CE102": 150,
+    "CE207": 150,
+    "CE208": 150,
+    "CE301": 50,
+    "CE303": 50,
+    "CE307": 50,
+    "CE308": 50,
+}
+MODELS = list(MODEL_DELAYS_MS)
+MODEL_AUTO = "AUTO"
+MODEL_NONE = "NONE"
+
 
 def validate_request_format(value):
     if not value.endswith(")"):
@@ -69,44 +130,281 @@ def validate_meter_address(value):
     return value
 
 
+def validate_meter_addresses(value):
+    if len(value) != len(set(value)):
+        raise cv.Invalid("Meter addresses must be unique")
+    if len(value) > 1 and "" in value:
+        raise cv.Invalid(
+            "Empty (broadcast) address can not be used with several meters on the bus"
+        )
+    return value
+
+
+def final_validate_sensor_meter_address(config):
+    if CONF_ADDRESS not in config:
+        return config
+    full_config = fv.full_config.get()
+    hub_path = full_config.get_path_for_id(config[CONF_ENERGOMERA_IEC_ID])[:-1]
+    hub_config = full_config.get_config_for_path(hub_path)
+    if config[CONF_ADDRESS] not in hub_config[CONF_ADDRESS]:
+        raise cv.Invalid(
+            f"Meter address '{config[CONF_ADDRESS]}' is not configured for '{config[CONF_ENERGOMERA_IEC_ID]}'"
+        )
+    return config
+
+
+# Rough model of a session on the wire, good enough to tell a tight schedule from an impossible one
+BITS_PER_CHAR = 10  # 7E1
+METER_TURNAROUND_MS = 60  # meter starts replying after this
+BAUD_CHANGE_PAUSES_MS = 250 + 150  # see OPEN_SESSION_GET_ID and SET_BAUD
+VALUE_CHARS = 12  # "(12345.678)"
+DEFAULT_SESSION_BAUD_RATE = 9600
+DEFAULT_DELAY_BETWEEN_REQUESTS_MS = 50
+BUS_UTILIZATION_WARNING = 0.8
+
+
+def chars_ms(chars, baud_rate):
+    return chars * BITS_PER_CHAR * 1000 / baud_rate
+
+
+def collect_requests(full_config, hub_config):
+    """{meter address: {request: number of values}} of all sensors of the hub"""
+    hub_id = hub_config[CONF_ID].id
+    default_address = hub_config[CONF_ADDRESS][0]
+    meters = {address: {} for address in hub_config[CONF_ADDRESS]}
+    for domain in ("sensor", "text_sensor"):
+        for conf in full_config.get(domain, []):
+            if conf.get(CONF_PLATFORM) != "energomera_iec" or CONF_REQUEST not in conf:
+                continue
+            if conf[CONF_ENERGOMERA_IEC_ID].id != hub_id:
+                continue
+            indexes = [v[CONF_INDEX] for v in conf.get("values", [])] or [
+                conf.get(CONF_INDEX, 1)
+            ]
+            requests = meters.setdefault(conf.get(CONF_ADDRESS, default_address), {})
+            request = conf[CONF_REQUEST]
+            requests[request] = max(requests.get(request, 1), *indexes)
+    return meters
+
+
+def estimate_session_ms(hub_config, address, requests, baud_rate):
+    handshake = hub_config[CONF_BAUD_RATE_HANDSHAKE]
+    turnaround = METER_TURNAROUND_MS
+    if CONF_LATENCY in hub_config:
+        turnaround += hub_config[CONF_LATENCY].total_milliseconds
+    if CONF_DELAY_BETWEEN_REQUESTS in hub_config:
+        delay = hub_config[CONF_DELAY_BETWEEN_REQUESTS].total_milliseconds
+    elif hub_config[CONF_MODEL] in MODEL_DELAYS_MS:
+        delay = MODEL_DELAYS_MS[hub_config[CONF_MODEL]]
+    elif hub_config[CONF_MODEL] == MODEL_AUTO:
+        delay = max(MODEL_DELAYS_MS.values())  # not known before the meter identifies
+    else:
+        delay = DEFAULT_DELAY_BETWEEN_REQUESTS_MS
+
+    # "/?address!", identification, ACK with mode, "(address)" reply
+    ms = chars_ms(len(address) + 5, handshake) + turnaround + chars_ms(16, handshake)
+    ms += chars_ms(6, handshake)
+    if baud_rate != handshake:
+        ms += BAUD_CHANGE_PAUSES_MS
+    ms += turnaround + chars_ms(len(address) + 8, baud_rate)
+    for request, values in requests.items():
+        ms += chars_ms(len(request) + 6, baud_rate) + turnaround
+        ms += chars_ms(len(request) + values * VALUE_CHARS + 5, baud_rate) + delay
+    return ms + chars_ms(5, baud_rate)
+
+
+def estimate_cycle_ms(full_config, hub_config, baud_rate):
+    meters = collect_requests(full_config, hub_config)
+    return sum(
+        estimate_session_ms(hub_config, address, requests, baud_rate)
+        for address, requests in meters.items()
+    )
+
+
+def bus_key(hub_config):
+    # same key as EnergomeraIecTcpTransport::find_bus_(), hubs behind one gateway
+    # share one bus lock on the device as well
+    if hub_config[CONF_TRANSPORT] == TRANSPORT_TCP:
+        return f"{str(hub_config[CONF_HOST])}:{hub_config[CONF_PORT]}"
+    return str(hub_config[CONF_UART_ID])
+
+
+def final_validate_session_cost(config):
+    """Components sharing a bus take turns, so their cycles add up against the update intervals"""
+    full_config = fv.full_config.get()
+    hubs = [h for h in full_config.get(DOMAIN, []) if bus_key(h) == bus_key(config)]
+    if hubs[0][CONF_ID].id != config[CONF_ID].id:
+        return config  # reported once per bus
+    can_change_baud_rate = config[CONF_TRANSPORT] == TRANSPORT_UART
+
+    def session_baud_rate(hub_config, override=None):
+        if not can_change_baud_rate:
+            return hub_config[CONF_BAUD_RATE_HANDSHAKE]
+        return override or hub_config.get(CONF_BAUD_RATE, DEFAULT_SESSION_BAUD_RATE)
+
+    def utilization(override=None):
+        total = 0
+        for hub in hubs:
+            interval = hub[CONF_UPDATE_INTERVAL].total_milliseconds
+            cycle = estimate_cycle_ms(full_config, hub, session_baud_rate(hub, override))
+            total += cycle / interval
+        return total
+
+    for hub in hubs:
+        interval = hub[CONF_UPDATE_INTERVAL].total_milliseconds
+        cycle = estimate_cycle_ms(full_config, hub, session_baud_rate(hub))
+        budget = interval * 0.8
+        if CONF_SESSION_BUDGET in hub:
+            budget = hub[CONF_SESSION_BUDGET].total_milliseconds
+        _LOGGER.info(
+            "'%s': estimated cycle %.1f s every %.0f s",
+            hub[CONF_ID].id,
+            cycle / 1000,
+            interval / 1000,
+        )
+        if cycle > budget:
+            _LOGGER.warning(
+                "'%s': estimated cycle of %.1f s does not fit the session budget "
+                "of %.1f s, requests will be spread over several polls",
+                hub[CONF_ID].id,
+                cycle / 1000,
+                budget / 1000,
+            )
+
+    used = utilization()
+    if used < BUS_UTILIZATION_WARNING:
+        return config
+    suggestions = []
+    for hub in hubs:
+        interval_ms = hub[CONF_UPDATE_INTERVAL].total_milliseconds
+        needed_s = math.ceil(interval_ms * used / BUS_UTILIZATION_WARNING / 1000)
+        suggestions.append(f"update_interval: {needed_s}s for '{hub[CONF_ID].id}'")
+    fastest = BAUD_RATES[-1]
+    if can_change_baud_rate and max(session_baud_rate(h) for h in hubs) < fastest:
+        faster = utilization(fastest)
+        suggestions.append(f"baud_rate: {fastest} (about {faster:.0%} of bus time)")
+    message = (
+        f"Bus '{bus_key(config)}' is busy about {used:.0%} of the time "
+        f"with the configured requests. Consider {' or '.join(suggestions)}"
+    )
+    # a rough estimate, so never an error: configs that work on real meters must still compile
+    if used > 1:
+        message += ". Polls would be skipped as 'component not ready'"
+    _LOGGER.warning(message)
+    return config
+
+
+def validate_align_to_clock(config):
+    if config[CONF_ALIGN_TO_CLOCK] and CONF_TIME_ID not in config:
+        raise cv.Invalid(f"'{CONF_ALIGN_TO_CLOCK}' requires '{CONF_TIME_ID}'")
+    return config
+
+
+def validate_auto_time_sync(config):
+    if config[CONF_AUTO_TIME_SYNC] and CONF_TIME_ID not in config:
+        raise cv.Invalid(f"'{CONF_AUTO_TIME_SYNC}' requires '{CONF_TIME_ID}'")
+    return config
+
+
+BRIDGE_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_PORT): cv.port,
+        cv.Optional(
+            CONF_IDLE_TIMEOUT, default=DEFAULTS_BRIDGE_IDLE_TIMEOUT
+        ): cv.positive_time_period_milliseconds,
+        cv.Optional(
+            CONF_MAX_SLOT, default=DEFAULTS_BRIDGE_MAX_SLOT
+        ): cv.positive_time_period_milliseconds,
+    }
+)
+
+BASE_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(EnergomeraIec),
+        cv.Optional(CONF_ADDRESS, default=""): cv.All(
+            cv.ensure_list(cv.string, validate_meter_address),
+            validate_meter_addresses,
+        ),
+        cv.Optional(
+            CONF_BAUD_RATE_HANDSHAKE, default=DEFAULTS_BAUD_RATE_HANDSHAKE
+        ): cv.one_of(*BAUD_RATES),
+        # without these three, values of the meter model profile are used
+        cv.Optional(CONF_BAUD_RATE): cv.one_of(*BAUD_RATES),
+        cv.Optional(CONF_RECEIVE_TIMEOUT): cv.positive_time_period_milliseconds,
+        cv.Optional(
+            CONF_DELAY_BETWEEN_REQUESTS
+        ): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_MODEL, default=MODEL_AUTO): cv.one_of(
+            MODEL_AUTO, MODEL_NONE, *MODELS, upper=True
+        ),
+        cv.Optional(
+            CONF_UPDATE_INTERVAL, default=DEFAULTS_UPDATE_INTERVAL
+        ): cv.update_interval,
+        cv.Optional(CONF_SESSION_BUDGET): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_REBOOT_AFTER_FAILURE, default=0): cv.int_range(
+            min=0, max=100
+        ),
+        cv.Optional(CONF_TIME_ID): cv.use_id(time.RealTimeClock),
+        cv.Optional(CONF_ALIGN_TO_CLOCK, default=False): cv.boolean,
+        cv.Optional(CONF_AUTO_TIME_SYNC, default=False): cv.boolean,
+        cv.Optional(CONF_STAGGER, default=True): cv.boolean,
+        cv.Optional(CONF_BUFFER_SIZE, default=0): cv.int_range(min=0, max=4096),
+        cv.Optional(CONF_RESTORE_VALUE, default=False): cv.boolean,
+        cv.Optional(CONF_RESTORED): binary_sensor.binary_sensor_schema(),
+        cv.Optional(
+            CONF_BOOT_WAIT, default=DEFAULTS_BOOT_WAIT
+        ): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_READOUT, default=False): cv.boolean,
+        cv.Optional(CONF_TRACE_SIZE, default=0): cv.int_range(min=0, max=256),
+        cv.Optional(CONF_BRIDGE): BRIDGE_SCHEMA,
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
 CONFIG_SCHEMA = cv.All(
-    cv.Schema(
+    cv.typed_schema(
         {
-            cv.GenerateID(): cv.declare_id(EnergomeraIec),
-            cv.Optional(CONF_ADDRESS, default=""): cv.All(
-                cv.string, validate_meter_address
-            ),
-            cv.Optional(CONF_FLOW_CONTROL_PIN): pins.gpio_output_pin_schema,
-            cv.Optional(
-                CONF_BAUD_RATE_HANDSHAKE, default=DEFAULTS_BAUD_RATE_HANDSHAKE
-            ): cv.one_of(*BAUD_RATES),
-            cv.Optional(CONF_BAUD_RATE, default=DEFAULTS_BAUD_RATE_SESSION): cv.one_of(
-                *BAUD_RATES
+            TRANSPORT_UART: BASE_SCHEMA.extend(
+                {
+                    cv.Optional(CONF_FLOW_CONTROL_PIN): pins.gpio_output_pin_schema,
+                }
+            ).extend(uart.UART_DEVICE_SCHEMA),
+            TRANSPORT_TCP: BASE_SCHEMA.extend(
+                {
+                    cv.Required(CONF_HOST): cv.ipv4address,
+                    cv.Required(CONF_PORT): cv.port,
+                    cv.Optional(
+                        CONF_LATENCY, default=DEFAULTS_TCP_LATENCY
+                    ): cv.positive_time_period_milliseconds,
+                }
             ),
-            cv.Optional(
-                CONF_RECEIVE_TIMEOUT, default=DEFAULTS_RECEIVE_TIMEOUT
-            ): cv.positive_time_period_milliseconds,
-            cv.Optional(
-                CONF_DELAY_BETWEEN_REQUESTS, default=DEFAULTS_DELAY_BETWEEN_REQUESTS
-            ): cv.positive_time_period_milliseconds,
-            cv.Optional(
-                CONF_UPDATE_INTERVAL, default=DEFAULTS_UPDATE_INTERVAL
-            ): cv.update_interval,
-            cv.Optional(CONF_REBOOT_AFTER_FAILURE, default=0): cv.int_range(
-                min=0, max=100
-            ),
-            cv.Optional(CONF_TIME_ID): cv.use_id(time.RealTimeClock),
-        }
-    )
-    .extend(cv.COMPONENT_SCHEMA)
-    .extend(uart.UART_DEVICE_SCHEMA)
+        },
+        key=CONF_TRANSPORT,
+        default_type=TRANSPORT_UART,
+    ),
+    validate_align_to_clock,
+    validate_auto_time_sync,
 )
 
 
+FINAL_VALIDATE_SCHEMA = final_validate_session_cost
+
+
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
+    # meters go first, sensors of the platforms refer to them by address
+    for address in config[CONF_ADDRESS]:
+        cg.add(var.add_meter(address))
     await cg.register_component(var, config)
-    await uart.register_uart_device(var, config)
+    if uses_socket(config):
+        cg.add_define("USE_ENERGOMERA_IEC_SOCKET")
+    if config[CONF_TRANSPORT] == TRANSPORT_TCP:
+        cg.add(
+            var.set_tcp_transport(
+                str(config[CONF_HOST]), config[CONF_PORT], config[CONF_LATENCY]
+            )
+        )
+    else:
+        await uart.register_uart_device(var, config)
 
     if flow_control_pin := config.get(CONF_FLOW_CONTROL_PIN):
         pin = await cg.gpio_pin_expression(flow_control_pin)
@@ -120,10 +418,35 @@ async def to_code(config):
     if CONF_TIME_ID in config:
         time_ = await cg.get_variable(config[CONF_TIME_ID])
         cg.add(var.set_time_source(time_))
+        cg.add(var.set_align_to_clock(config[CONF_ALIGN_TO_CLOCK]))
+        cg.add(var.set_auto_time_sync(config[CONF_AUTO_TIME_SYNC]))
         
-    cg.add(var.set_meter_address(config[CONF_ADDRESS]))
-    cg.add(var.set_baud_rates(config[CONF_BAUD_RATE_HANDSHAKE], config[CONF_BAUD_RATE]))
-    cg.add(var.set_receive_timeout_ms(config[CONF_RECEIVE_TIMEOUT]))
-    cg.add(var.set_delay_between_requests_ms(config[CONF_DELAY_BETWEEN_REQUESTS]))
+    cg.add(var.set_baud_rate_handshake(config[CONF_BAUD_RATE_HANDSHAKE]))
+    if CONF_BAUD_RATE in config:
+        cg.add(var.set_baud_rate(config[CONF_BAUD_RATE]))
+    if CONF_RECEIVE_TIMEOUT in config:
+        cg.add(var.set_receive_timeout_ms(config[CONF_RECEIVE_TIMEOUT]))
+    if CONF_DELAY_BETWEEN_REQUESTS in config:
+        cg.add(var.set_delay_between_requests_ms(config[CONF_DELAY_BETWEEN_REQUESTS]))
+    cg.add(var.set_model(config[CONF_MODEL]))
+    if bridge_config := config.get(CONF_BRIDGE):
+        cg.add(
+            var.set_bridge(
+                bridge_config[CONF_PORT],
+                bridge_config[CONF_IDLE_TIMEOUT],
+                bridge_config[CONF_MAX_SLOT],
+            )
+        )
     cg.add(var.set_update_interval(config[CONF_UPDATE_INTERVAL]))
     cg.add(var.set_reboot_after_failure(config[CONF_REBOOT_AFTER_FAILURE]))
+    cg.add(var.set_stagger(config[CONF_STAGGER]))
+    cg.add(var.set_buffer_size(config[CONF_BUFFER_SIZE]))
+    cg.add(var.set_restore_value(config[CONF_RESTORE_VALUE]))
+    if restored_config := config.get(CONF_RESTORED):
+        sens = await binary_sensor.new_binary_sensor(restored_config)
+        cg.add(var.set_restored_sensor(sens))
+    cg.add(var.set_boot_wait_ms(config[CONF_BOOT_WAIT]))
+    cg.add(var.set_readout(config[CONF_READOUT]))
+    cg.add(var.set_trace_size(config[CONF_TRACE_SIZE]))
+    if CONF_SESSION_BUDGET in config:
+        cg.add(var.set_session_budget_ms(config[CONF_SESSION_BUDGET]))
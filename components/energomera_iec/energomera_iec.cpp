@@ -3,13 +3,12 @@
 #include "esphome/core/application.h"
 #include "esphome/core/time.h"
 #include "energomera_iec.h"
-#include <sstream>
 
 namespace esphome {
 namespace energomera_iec {
 
 static const char *TAG0 = "energomera_iec_";
-#define TAG (this->tag_.c_str())
+#define TAG (this->tag_)
 
 static constexpr uint8_t SOH = 0x01;
 static constexpr uint8_t STX = 0x02;
@@ -22,68 +21,142 @@ static constexpr uint8_t LF = 0x0A;
 static constexpr uint8_t NAK = 0x15;
 
 static const uint8_t CMD_ACK_SET_BAUD_AND_MODE[] = {ACK, '0', '5', '1', CR, LF};
+static const uint8_t CMD_ACK_READOUT[] = {ACK, '0', '5', '0', CR, LF};
 static const uint8_t CMD_CLOSE_SESSION[] = {SOH, 0x42, 0x30, ETX, 0x75};
 
-static constexpr uint8_t BOOT_WAIT_S = 10;
+// used when neither YAML nor a meter profile says otherwise
+static constexpr uint32_t DEFAULT_RECEIVE_TIMEOUT_MS = 500;
+static constexpr uint32_t DEFAULT_DELAY_BETWEEN_REQUESTS_MS = 50;
+
+// bus is considered idle after this much silence at boot
+static constexpr uint32_t BOOT_QUIET_MS = 500;
+static constexpr uint32_t BOOT_CHECK_INTERVAL_MS = 100;
+static constexpr uint32_t BUFFER_DRAIN_INTERVAL_MS = 100;
+static constexpr uint8_t BUFFER_DRAIN_BATCH = 10;
+// meters drop the session after 1.5..3 s of silence, so only short pauses between burst cycles keep it open
+static constexpr uint32_t BURST_KEEP_SESSION_MAX_MS = 1000;
+// meters take at most this much clock correction a day, smaller offsets are left alone
+static constexpr uint8_t MAX_DAILY_CORRECTION_S = 29;
+static constexpr float MIN_CLOCK_CORRECTION_S = 2.0f;
+// no clock check this close to midnight: DATE_ and TIME_ may be of different days, CTIME may cross the date
+static constexpr uint8_t MIDNIGHT_GUARD_MIN = 5;
+// drift is only estimated over longer intervals, clock reads are whole seconds
+static constexpr float MIN_DRIFT_INTERVAL_DAYS = 1.0f / 24;
+static constexpr float DRIFT_SMOOTHING = 0.3f;
+// meter does not take a new sign-on right after it finished the readout
+static constexpr uint32_t READOUT_REOPEN_DELAY_MS = 300;
+static constexpr uint8_t READOUT_MAX_FAILURES = 3;
+static constexpr uint8_t READOUT_REPROBE_SESSIONS = 50;  // a readout that missed requests is tried again this often
+
+static constexpr size_t FRAME_PRETTY_SIZE = 320;
+
+// an instance that found the bus busy checks it again after this
+static constexpr uint32_t BUS_LOCK_RETRY_MS = 1000;
+// gateway connection in progress, the poll waits for it
+static constexpr uint32_t TRANSPORT_RETRY_MS = 50;
+#ifdef USE_ENERGOMERA_IEC_SOCKET
+// bridge listener is checked this often between polls, loop() runs only while a client has the bus
+static constexpr uint32_t BRIDGE_LISTEN_INTERVAL_MS = 50;
+#endif
+
+// limits for running states back-to-back in one loop() call
+static constexpr uint8_t MAX_HOPS_PER_LOOP = 16;
+static constexpr uint32_t MAX_HOPS_TIME_MS = 20;
 
 static char empty_str[] = "";
 
+static bool is_near_midnight(const ESPTime &time) {
+  uint16_t minute_of_day = time.hour * 60 + time.minute;
+  return minute_of_day < MIDNIGHT_GUARD_MIN || minute_of_day >= 24 * 60 - MIDNIGHT_GUARD_MIN;
+}
+
+// "ET0PE" -> "ET0PE()", false if that does not fit
+static bool make_request(char *req, size_t size, const char *name) {
+  size_t len = strlen(name);
+  if (len + sizeof("()") > size)
+    return false;
+  memcpy(req, name, len);
+  memcpy(req + len, "()", sizeof("()"));
+  return true;
+}
+
 static char format_hex_char(uint8_t v) { return v >= 10 ? 'A' + (v - 10) : '0' + v; }
 
-static std::string format_frame_pretty(const uint8_t *data, size_t length) {
-  if (length == 0)
-    return "";
-  std::string ret;
-  ret.resize(3 * length - 1);
-  std::ostringstream ss(ret);
+// Rendered into a static buffer valid until the next call, so logging a frame does not touch the heap.
+// Long frames are cut.
+static const char *format_frame_pretty(const uint8_t *data, size_t length) {
+  static char buf[FRAME_PRETTY_SIZE];
+  // room for the longest token and the " ... (NNN)" tail
+  const size_t limit = FRAME_PRETTY_SIZE - 16;
+  size_t pos = 0;
+
+  auto append = [&pos](const char *str) {
+    while (*str)
+      buf[pos++] = *str++;
+  };
 
-  for (size_t i = 0; i < length; i++) {
+  size_t i = 0;
+  for (; i < length && pos < limit; i++) {
     switch (data[i]) {
       case 0x00:
-        ss << "<NUL>";
+        append("<NUL>");
         break;
       case 0x01:
-        ss << "<SOH>";
+        append("<SOH>");
         break;
       case 0x02:
-        ss << "<STX>";
+        append("<STX>");
         break;
       case 0x03:
-        ss << "<ETX>";
+        append("<ETX>");
         break;
       case 0x04:
-        ss << "<EOT>";
+        append("<EOT>");
         break;
       case 0x05:
-        ss << "<ENQ>";
+        append("<ENQ>");
         break;
       case 0x06:
-        ss << "<ACK>";
+        append("<ACK>");
         break;
       case 0x0d:
-        ss << "<CR>";
+        append("<CR>");
         break;
       case 0x0a:
-        ss << "<LF>";
+        append("<LF>");
         break;
       case 0x15:
-        ss << "<NAK>";
+        append("<NAK>");
         break;
       case 0x20:
-        ss << "<SP>";
+        append("<SP>");
         break;
       default:
         if (data[i] <= 0x20 || data[i] >= 0x7f) {
-          ss << "<" << format_hex_char((data[i] & 0xF0) >> 4) << format_hex_char(data[i] & 0x0F) << ">";
+          buf[pos++] = '<';
+          buf[pos++] = format_hex_char((data[i] & 0xF0) >> 4);
+          buf[pos++] = format_hex_char(data[i] & 0x0F);
+          buf[pos++] = '>';
         } else {
-          ss << (char) data[i];
+          buf[pos++] = (char) data[i];
         }
         break;
     }
   }
+  if (i < length)
+    append(" ...");
   if (length > 4)
-    ss << " (" << length << ")";
-  return ss.str();
+    pos += snprintf(buf + pos, FRAME_PRETTY_SIZE - pos, " (%u)", (unsigned) length);
+  buf[pos] = '\0';
+  return buf;
+}
+
+uint32_t byte_to_baud_rate(uint8_t baud) {
+  constexpr uint16_t BAUD_BASE = 300;
+  constexpr uint8_t BAUD_MULT_MAX = 6;
+  if (baud < '0' || baud > '0' + BAUD_MULT_MAX)
+    return 0;
+  return BAUD_BASE * (1 << (baud - '0'));
 }
 
 uint8_t baud_rate_to_byte(uint32_t baud) {
@@ -102,68 +175,350 @@ uint8_t baud_rate_to_byte(uint32_t baud) {
 
 void EnergomeraIecComponent::set_baud_rate_(uint32_t baud_rate) {
   ESP_LOGV(TAG, "Setting baud rate %u bps", baud_rate);
-  iuart_->update_baudrate(baud_rate);
+  this->transport_->update_baudrate(baud_rate);
 }
 
 void EnergomeraIecComponent::setup() {
   ESP_LOGD(TAG, "setup");
 
-#ifdef USE_ESP32
-  iuart_ = make_unique<EnergomeraIecUart>(*static_cast<uart::IDFUARTComponent *>(this->parent_));
-#endif
-
-#if USE_ESP8266
-  iuart_ = make_unique<EnergomeraIecUart>(*static_cast<uart::ESP8266UartComponent *>(this->parent_));
-#endif
+  if (this->transport_ == nullptr) {
+    this->transport_ = make_unique<EnergomeraIecUartTransport>(this->parent_);
+  }
+  this->timeout_margin_ms_ = this->transport_->get_timeout_margin_ms();
+  this->throughput_.started_ms = millis();
   if (this->flow_control_pin_ != nullptr) {
     this->flow_control_pin_->setup();
   }
   this->set_baud_rate_(this->baud_rate_handshake_);
-  this->set_timeout(BOOT_WAIT_S * 1000, [this]() {
-    ESP_LOGD(TAG, "Boot timeout, component is ready to use");
+  if (this->meters_.empty()) {
+    this->find_or_add_meter_("");
+  }
+  for (auto &meter : this->meters_) {
+    meter.resume_iter = meter.sensors.begin();
+    meter.open_cmd_size = snprintf((char *) meter.open_cmd, sizeof(meter.open_cmd), "/?%s!\r\n", meter.address);
+  }
+  this->build_frame_table_();
+  this->meter_idx_ = 0;
+  this->meter_ = &this->meters_[0];
+  if (this->trace_size_ > 0) {
+    this->trace_.init(this->trace_size_);
+  }
+  if (this->buffer_size_ > 0) {
+    this->reading_buffer_.init(this->buffer_size_);
+    this->set_interval("buffer_drain", BUFFER_DRAIN_INTERVAL_MS, [this]() { this->drain_reading_buffer_(); });
+  }
+  if (this->restore_value_) {
+    this->restore_values_();
+  }
+  for (auto &meter : this->meters_) {
+    this->meter_ = &meter;
+    this->select_profile_();
+  }
+  this->meter_ = &this->meters_[0];
+  this->boot_started_ms_ = millis();
+  this->boot_last_rx_ms_ = this->boot_started_ms_;
+  this->set_interval("boot", BOOT_CHECK_INTERVAL_MS, [this]() { this->check_boot_done_(); });
+#ifdef USE_ENERGOMERA_IEC_SOCKET
+  if (this->bridge_ != nullptr)
+    this->set_interval("bridge", BRIDGE_LISTEN_INTERVAL_MS, [this]() { this->bridge_listen_(); });
+#endif
+}
+
+// Whatever was on the wire during boot is discarded. First poll goes once the bus is quiet, or boot_wait at most.
+void EnergomeraIecComponent::check_boot_done_() {
+  uint32_t now = millis();
+  if (this->transport_->available() > 0) {
     this->clear_rx_buffers_();
-    this->set_next_state_(State::IDLE);
-  });
+    this->boot_last_rx_ms_ = now;
+  }
+  bool quiet = now - this->boot_last_rx_ms_ >= BOOT_QUIET_MS;
+  bool timed_out = now - this->boot_started_ms_ >= this->boot_wait_ms_;
+  if (!quiet && !timed_out)
+    return;
+
+  this->cancel_interval("boot");
+  ESP_LOGD(TAG, "Boot done in %u ms (%s), component is ready to use", now - this->boot_started_ms_,
+           quiet ? "bus quiet" : "timeout");
+  this->clear_rx_buffers_();
+  this->loop_stats_.woken_ms = now;
+  this->set_next_state_(State::IDLE);
+  // instances on one bus keep their slots from the very first poll
+  uint32_t offset_ms = this->stagger_offset_ms_();
+  if (offset_ms == 0) {
+    this->start_poll_();
+  } else {
+    this->schedule_poll_(offset_ms);
+  }
+}
+
+void EnergomeraIecComponent::restore_values_() {
+  uint32_t restored = 0;
+  for (auto &meter : this->meters_) {
+    uint32_t hash = fnv1_hash(str_sprintf("energomera_iec/%s", meter.address));
+    meter.identity_pref = global_preferences->make_preference<decltype(meter.identity)>(hash);
+    if (meter.identity_pref.load(&meter.identity)) {
+      meter.identity[sizeof(meter.identity) - 1] = '\0';
+      ESP_LOGD(TAG, "Meter '%s' identity before reboot: '%s'", meter.address, meter.identity);
+    }
+    meter.clock_pref = global_preferences->make_preference<decltype(meter.clock)>(
+        fnv1_hash(str_sprintf("energomera_iec/%s/clock", meter.address)));
+    if (meter.clock_pref.load(&meter.clock) && meter.clock.drift_known) {
+      ESP_LOGD(TAG, "Meter '%s' clock drift before reboot: %+.2f s/day", meter.address, meter.clock.drift_s_per_day);
+    }
+
+    for (auto &kv : meter.sensors) {
+      auto *sensor = kv.second;
+      std::vector<EnergomeraIecSensor *> numeric;
+      if (sensor->get_type() == SensorType::SENSOR) {
+        numeric.push_back(static_cast<EnergomeraIecSensor *>(sensor));
+      } else if (sensor->get_type() == SensorType::SENSOR_GROUP) {
+        numeric = static_cast<EnergomeraIecSensorGroup *>(sensor)->get_sensors();
+      }
+      // keyed by what the value is, not by entity name
+      for (auto *value : numeric) {
+        value->setup_restore(fnv1_hash(str_sprintf("energomera_iec/%s/%s/%u/%u", meter.address, kv.first.c_str(),
+                                                   value->get_index(), value->get_sub_index())));
+        if (value->is_restored())
+          restored++;
+      }
+    }
+  }
+  ESP_LOGD(TAG, "Restored %u value(s) from before reboot", restored);
+  this->publish_restored_();
+}
+
+void EnergomeraIecComponent::publish_restored_() {
+  if (this->restored_sensor_ == nullptr)
+    return;
+  bool restored = false;
+  for (auto &meter : this->meters_) {
+    for (auto &kv : meter.sensors) {
+      auto *sensor = kv.second;
+      if (sensor->get_type() == SensorType::SENSOR) {
+        restored |= static_cast<EnergomeraIecSensor *>(sensor)->is_restored();
+      } else if (sensor->get_type() == SensorType::SENSOR_GROUP) {
+        for (auto *value : static_cast<EnergomeraIecSensorGroup *>(sensor)->get_sensors())
+          restored |= value->is_restored();
+      }
+    }
+  }
+  if (!this->restored_sensor_->has_state() || this->restored_sensor_->state != restored)
+    this->restored_sensor_->publish_state(restored);
+}
+
+// Only values read in the current cycle are published and combined by derived sensors
+void EnergomeraIecComponent::clear_values_() {
+  for (auto &meter : this->meters_) {
+    for (auto &kv : meter.sensors)
+      kv.second->reset();
+  }
 }
 
 void EnergomeraIecComponent::dump_config() {
   ESP_LOGCONFIG(TAG, "Energomera IEC: %p", this);
 
   LOG_UPDATE_INTERVAL(this);
+  this->transport_->dump_config(TAG);
   LOG_PIN("  Flow Control Pin: ", this->flow_control_pin_);
+  if (this->reading_buffer_.enabled()) {
+    ESP_LOGCONFIG(TAG, "  Store-and-forward buffer: %u readings", (unsigned) this->reading_buffer_.capacity());
+  }
   ESP_LOGCONFIG(TAG, "  Receive Timeout: %ums", this->receive_timeout_ms_);
-  ESP_LOGCONFIG(TAG, "  Supported Meter Types: CE102M/CE301/CE303/...");
-  ESP_LOGCONFIG(TAG, "  Sensors:");
-  for (const auto &sensors : sensors_) {
-    auto &s = sensors.second;
-    ESP_LOGCONFIG(TAG, "    REQUEST: %s", s->get_request().c_str());
+  ESP_LOGCONFIG(TAG, "  Data readout: %s", YESNO(this->readout_));
+#ifdef USE_ENERGOMERA_IEC_SOCKET
+  if (this->bridge_ != nullptr) {
+    this->bridge_->dump_config(TAG);
+    ESP_LOGCONFIG(TAG, "    Idle timeout: %ums, max slot: %ums", this->bridge_idle_timeout_ms_,
+                  this->bridge_max_slot_ms_);
+  }
+#endif
+  if (this->trace_.capacity() > 0) {
+    ESP_LOGCONFIG(TAG, "  Frame trace: %u frames, %s", (unsigned) this->trace_.capacity(),
+                  this->trace_.enabled() ? "on" : "off");
+  }
+  std::string models;
+  for (const auto &profile : METER_PROFILES) {
+    models += models.empty() ? "" : "/";
+    models += profile.model;
+  }
+  ESP_LOGCONFIG(TAG, "  Meter profiles: %s", models.c_str());
+  ESP_LOGCONFIG(TAG, "  Model: %s", this->model_.c_str());
+  for (const auto &meter : this->meters_) {
+    ESP_LOGCONFIG(TAG, "  Meter address: '%s', identity: '%s', profile: %s", meter.address, meter.identity,
+                  meter.profile != nullptr ? meter.profile->model : "none");
+    ESP_LOGCONFIG(TAG, "    Sensors:");
+    for (const auto &sensors : meter.sensors) {
+      auto &s = sensors.second;
+      ESP_LOGCONFIG(TAG, "      REQUEST: %s", s->get_request().c_str());
+    }
+  }
+}
+
+void EnergomeraIecComponent::select_profile_() {
+  auto *meter = this->meter_;
+  if (this->model_ == "NONE") {
+    meter->profile = nullptr;
+  } else if (this->model_ == "AUTO") {
+    meter->profile = find_meter_profile_by_identity(meter->identity);
+  } else {
+    meter->profile = find_meter_profile(this->model_.c_str());
+  }
+  if (meter->profile != nullptr) {
+    ESP_LOGD(TAG, "Meter '%s' uses %s profile", meter->address, meter->profile->model);
+  } else if (meter->identity[0] != '\0') {
+    ESP_LOGD(TAG, "No profile for meter '%s' ('%s'), using defaults", meter->address, meter->identity);
   }
 }
 
+// Settings not given in YAML follow the meter in session: timings from its profile,
+// session speed up to the maximum it reported in the identification, whatever the model
+void EnergomeraIecComponent::apply_profile_() {
+  const auto *profile = this->meter_->profile;
+  if (!this->configured_.receive_timeout)
+    this->receive_timeout_ms_ = profile != nullptr ? profile->receive_timeout_ms : DEFAULT_RECEIVE_TIMEOUT_MS;
+  if (!this->configured_.delay_between_requests) {
+    this->delay_between_requests_ms_ =
+        profile != nullptr ? profile->delay_between_requests_ms : DEFAULT_DELAY_BETWEEN_REQUESTS_MS;
+  }
+  if (!this->configured_.baud_rate) {
+    uint32_t max_baud_rate = byte_to_baud_rate(this->meter_->identity[4]);  // 0 without an identification
+    this->baud_rate_ = max_baud_rate > this->baud_rate_handshake_ ? max_baud_rate : this->baud_rate_handshake_;
+  }
+}
+
+void EnergomeraIecComponent::add_meter(const char *address) { this->find_or_add_meter_(address); }
+
+EnergomeraIecComponent::Meter *EnergomeraIecComponent::find_or_add_meter_(const char *address) {
+  for (auto &meter : this->meters_) {
+    if (strncmp(meter.address, address, sizeof(meter.address)) == 0)
+      return &meter;
+  }
+  this->meters_.emplace_back();
+  auto &meter = this->meters_.back();
+  strncpy(meter.address, address, sizeof(meter.address) - 1);
+  return &meter;
+}
+
 void EnergomeraIecComponent::register_sensor(EnergomeraIecSensorBase *sensor) {
-  this->sensors_.insert({sensor->get_request(), sensor});
+  if (this->meters_.empty()) {
+    this->find_or_add_meter_("");
+  }
+  this->meters_[0].sensors.insert({sensor->get_request(), sensor});
+}
+
+void EnergomeraIecComponent::register_sensor(EnergomeraIecSensorBase *sensor, const char *meter_address) {
+  this->find_or_add_meter_(meter_address)->sensors.insert({sensor->get_request(), sensor});
 }
 
 void EnergomeraIecComponent::abort_mission_() {
   // try close connection ?
   ESP_LOGE(TAG, "Abort mission. Closing session");
   this->send_frame_(CMD_CLOSE_SESSION, sizeof(CMD_CLOSE_SESSION));
-  this->unlock_uart_session_();
-  this->set_next_state_(State::IDLE);
+  this->loop_state_.session_open = false;
   this->report_failure(true);
+  this->session_done_();
 }
 
 void EnergomeraIecComponent::report_failure(bool failure) {
   if (!failure) {
-    this->stats_.failures_ = 0;
+    this->meter_->stats.failures_ = 0;
+    if (this->recovery_.level != Recovery::NONE) {
+      this->recovery_.fixed[(size_t) this->recovery_.level]++;
+      ESP_LOGI(TAG, "Recovered at step %s after %u ms", this->recovery_to_string_(this->recovery_.level),
+               millis() - this->recovery_.level_started_ms);
+      this->set_recovery_level_(Recovery::NONE);
+    }
+    this->recovery_.failures = 0;
+    this->recovery_.backoff_factor = 1;
+    this->recovery_.polls_to_skip = 0;
     return;
   }
 
-  this->stats_.failures_++;
-  if (this->failures_before_reboot_ > 0 && this->stats_.failures_ > this->failures_before_reboot_) {
-    ESP_LOGE(TAG, "Too many failures in a row. Let's try rebooting device.");
-    delay(100);
-    App.safe_reboot();
+  if (this->meter_->stats.failures_ < UINT8_MAX) {
+    this->meter_->stats.failures_++;
+  }
+  // a single dead meter does not justify recovery while others on the bus answer
+  uint8_t bus_failures = UINT8_MAX;
+  for (const auto &meter : this->meters_) {
+    bus_failures = std::min(bus_failures, meter.stats.failures_);
+  }
+  // the first failure may be noise, escalate once per further full failed cycle
+  if (bus_failures < 2 || bus_failures <= this->recovery_.failures)
+    return;
+  this->recovery_.failures = bus_failures;
+  this->escalate_recovery_();
+}
+
+void EnergomeraIecComponent::escalate_recovery_() {
+  auto level = this->recovery_.level;
+  if (level < Recovery::BACK_OFF)
+    level = static_cast<Recovery>((uint8_t) level + 1);
+  if (level == Recovery::TOGGLE_FLOW_PIN && this->flow_control_pin_ == nullptr)
+    level = Recovery::BACK_OFF;
+  // reboot only after the soft steps had their chance
+  if (level == Recovery::BACK_OFF && this->recovery_.level == Recovery::BACK_OFF && this->failures_before_reboot_ > 0 &&
+      this->recovery_.failures > this->failures_before_reboot_)
+    level = Recovery::REBOOT;
+
+  this->set_recovery_level_(level);
+  switch (level) {
+    case Recovery::RESET_LINK:
+      ESP_LOGW(TAG, "Recovery: resetting link, back to handshake baud rate");
+      this->transport_->reset();
+      this->clear_rx_buffers_();
+      if (this->transport_->supports_baud_rate_change())
+        this->set_baud_rate_(this->baud_rate_handshake_);
+      break;
+
+    case Recovery::TOGGLE_FLOW_PIN:
+      ESP_LOGW(TAG, "Recovery: toggling flow control pin");
+      this->flow_control_pin_->digital_write(true);
+      delay(10);
+      this->flow_control_pin_->digital_write(false);
+      break;
+
+    case Recovery::BACK_OFF:
+      ESP_LOGW(TAG, "Recovery: polling every %u update intervals", this->recovery_.backoff_factor);
+      this->recovery_.polls_to_skip = this->recovery_.backoff_factor - 1;
+      if (this->recovery_.backoff_factor < 8)
+        this->recovery_.backoff_factor *= 2;
+      break;
+
+    case Recovery::REBOOT:
+      ESP_LOGE(TAG, "Too many failures in a row. Let's try rebooting device.");
+      delay(100);
+      App.safe_reboot();
+      break;
+
+    default:
+      break;
+  }
+}
+
+void EnergomeraIecComponent::set_recovery_level_(Recovery level) {
+  uint32_t now = millis();
+  if (this->recovery_.level != Recovery::NONE)
+    this->recovery_.time_ms[(size_t) this->recovery_.level] += now - this->recovery_.level_started_ms;
+  if (level != this->recovery_.level || level == Recovery::BACK_OFF)
+    this->recovery_.entered[(size_t) level]++;
+  this->recovery_.level = level;
+  this->recovery_.level_started_ms = now;
+}
+
+const char *EnergomeraIecComponent::recovery_to_string_(Recovery level) {
+  switch (level) {
+    case Recovery::NONE:
+      return "NONE";
+    case Recovery::RESET_LINK:
+      return "RESET_LINK";
+    case Recovery::TOGGLE_FLOW_PIN:
+      return "TOGGLE_FLOW_PIN";
+    case Recovery::BACK_OFF:
+      return "BACK_OFF";
+    case Recovery::REBOOT:
+      return "REBOOT";
+    default:
+      return "UNKNOWN";
   }
 }
 
@@ -171,12 +526,59 @@ void EnergomeraIecComponent::loop() {
   if (!this->is_ready() || this->state_ == State::NOT_INITIALIZED)
     return;
 
+  this->check_poll_deadline_();
+
+#ifdef USE_ENERGOMERA_IEC_SOCKET
+  if (this->bridge_ != nullptr)
+    this->bridge_loop_();
+#endif
+
+  if (this->state_ == State::IDLE) {
+    this->loop_stats_.idle_calls++;
+  } else {
+    this->loop_stats_.active_calls++;
+  }
+
+  // States that do not wait for anything run straight one after another instead of a loop() call each
+  uint32_t started_ms = millis();
+  uint8_t hops = 0;
+  while (true) {
+    State state = this->state_;
+    this->run_state_();
+    if (this->state_ == state || this->is_waiting_state_(this->state_))
+      break;
+    if (++hops >= MAX_HOPS_PER_LOOP || millis() - started_ms >= MAX_HOPS_TIME_MS)
+      break;
+  }
+  this->loop_stats_.hops += hops;
+  this->loop_stats_.max_hops = std::max(this->loop_stats_.max_hops, hops);
+}
+
+bool EnergomeraIecComponent::is_waiting_state_(State state) {
+  switch (state) {
+    case State::NOT_INITIALIZED:
+    case State::IDLE:
+    case State::WAIT:
+    case State::WAITING_FOR_RESPONSE:
+    case State::READOUT:
+    case State::BRIDGE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void EnergomeraIecComponent::run_state_() {
   ValueRefsArray vals;                                  // values from brackets, refs to this->buffers_.in
   char *in_param_ptr = (char *) &this->buffers_.in[1];  // ref to second byte, first is STX/SOH in R1 requests
 
   switch (this->state_) {
     case State::IDLE: {
-      this->update_last_rx_time_();
+      if (this->burst_.pending) {
+        this->activate_burst_();
+        break;
+      }
+      this->sleep_();
       // auto request = this->single_requests_.front();
 
       // if (this->single_requests_.empty())
@@ -186,18 +588,47 @@ void EnergomeraIecComponent::loop() {
       // ESP_LOGD(TAG, "Performing single request '%s'", request.c_str());
       // this->prepare_non_session_prog_frame_(request.c_str());
       // this->send_frame_prepared_();
-      // auto read_fn = [this]() { return this->receive_prog_frame_(STX, true); };
-      // this->read_reply_and_go_next_state_(read_fn, State::SINGLE_READ_ACK, 3, false, true);
+      // this->read_reply_and_go_next_state_(Reader::PROG_STX, State::SINGLE_READ_ACK, 3, false, true);
 
     } break;
 
     case State::TRY_LOCK_BUS: {
       this->log_state_();
+      if (!this->transport_->is_ready()) {
+        if (this->transport_->is_connecting()) {
+          ESP_LOGV(TAG, "Transport is connecting, waiting ...");
+          this->set_next_state_delayed_(TRANSPORT_RETRY_MS, State::TRY_LOCK_BUS);
+          break;
+        }
+        ESP_LOGW(TAG, "Transport is not ready, skipping session");
+        this->lock_wait_.waiting = false;
+        this->report_failure(true);
+        this->set_next_state_(State::IDLE);
+        break;
+      }
+      auto &lw = this->lock_wait_;
       if (this->try_lock_uart_session_()) {
+        if (lw.waiting) {
+          uint32_t waited_ms = millis() - lw.started_ms;
+          lw.waiting = false;
+          lw.waits++;
+          lw.total_ms += waited_ms;
+          lw.max_ms = std::max(lw.max_ms, waited_ms);
+          if (waited_ms >= this->get_update_interval()) {
+            lw.starved++;
+            ESP_LOGW(TAG, "Waited %u ms for the bus, longer than update interval", waited_ms);
+          } else {
+            ESP_LOGV(TAG, "Waited %u ms for the bus", waited_ms);
+          }
+        }
         this->set_next_state_(State::OPEN_SESSION);
       } else {
         ESP_LOGV(TAG, "UART Bus is busy, waiting ...");
-        this->set_next_state_delayed_(1000, State::TRY_LOCK_BUS);
+        if (!lw.waiting) {
+          lw.waiting = true;
+          lw.started_ms = millis();
+        }
+        this->set_next_state_delayed_(BUS_LOCK_RETRY_MS, State::TRY_LOCK_BUS);
       }
     } break;
 
@@ -210,20 +641,25 @@ void EnergomeraIecComponent::loop() {
 
     case State::WAITING_FOR_RESPONSE: {
       this->log_state_(&reading_state_.next_state);
-      received_frame_size_ = reading_state_.read_fn();
+      received_frame_size_ = this->read_frame_(reading_state_.reader);
 
       bool crc_is_ok = true;
       if (reading_state_.check_crc && received_frame_size_ > 0) {
         crc_is_ok = check_crc_prog_frame_(this->buffers_.in, received_frame_size_);
+        if (this->trace_.enabled())
+          this->trace_.set_last_check(crc_is_ok ? FrameTrace::Check::BCC_OK : FrameTrace::Check::BCC_FAILED);
       }
 
       // happy path first
       if (received_frame_size_ > 0 && crc_is_ok) {
+        bool prog_frame = reading_state_.reader == Reader::PROG_SOH || reading_state_.reader == Reader::PROG_STX;
+        if (prog_frame && received_frame_size_ > 3)
+          this->buffers_.in[received_frame_size_ - 2] = '\0';  // data ends at ETX, BCC may look like a bracket
         this->set_next_state_(reading_state_.next_state);
         this->update_last_rx_time_();
-        this->stats_.crc_errors_ += reading_state_.err_crc;
-        this->stats_.crc_errors_recovered_ += reading_state_.err_crc;
-        this->stats_.invalid_frames_ += reading_state_.err_invalid_frames;
+        this->meter_->stats.crc_errors_ += reading_state_.err_crc;
+        this->meter_->stats.crc_errors_recovered_ += reading_state_.err_crc;
+        this->meter_->stats.invalid_frames_ += reading_state_.err_invalid_frames;
         return;
       }
 
@@ -250,15 +686,17 @@ void EnergomeraIecComponent::loop() {
       // - or corrupted data and id doesn't trigger stop function
       if (this->buffers_.amount_in > 0) {
         // most likely its CRC error in STX/SOH/ETX. unclear.
-        this->stats_.crc_errors_++;
-        ESP_LOGV(TAG, "RX: %s", format_frame_pretty(this->buffers_.in, this->buffers_.amount_in).c_str());
+        this->meter_->stats.crc_errors_++;
+        this->trace_frame_(FrameTrace::Direction::RX, this->buffers_.in, this->buffers_.amount_in,
+                           FrameTrace::Check::INCOMPLETE);
+        ESP_LOGV(TAG, "RX: %s", format_frame_pretty(this->buffers_.in, this->buffers_.amount_in));
         ESP_LOGVV(TAG, "RX: %s", format_hex_pretty(this->buffers_.in, this->buffers_.amount_in).c_str());
       }
       this->clear_rx_buffers_();
 
       if (reading_state_.mission_critical) {
-        this->stats_.crc_errors_ += reading_state_.err_crc;
-        this->stats_.invalid_frames_ += reading_state_.err_invalid_frames;
+        this->meter_->stats.crc_errors_ += reading_state_.err_crc;
+        this->meter_->stats.invalid_frames_ += reading_state_.err_invalid_frames;
         this->abort_mission_();
         return;
       }
@@ -272,15 +710,29 @@ void EnergomeraIecComponent::loop() {
       }
       received_frame_size_ = 0;
       // failure, advancing to next state with no data received (frame_size = 0)
-      this->stats_.crc_errors_ += reading_state_.err_crc;
-      this->stats_.invalid_frames_ += reading_state_.err_invalid_frames;
+      this->meter_->stats.crc_errors_ += reading_state_.err_crc;
+      this->meter_->stats.invalid_frames_ += reading_state_.err_invalid_frames;
       this->set_next_state_(reading_state_.next_state);
     } break;
 
     case State::OPEN_SESSION: {
-      this->stats_.connections_tried_++;
-      this->loop_state_.session_started_ms = millis();
+      this->meter_->stats.connections_tried_++;
+      if (!this->loop_state_.readout_fallback) {
+        this->loop_state_.session_started_ms = millis();
+        if (this->meter_idx_ == 0) {
+          this->loop_state_.cycle_started_ms = this->loop_state_.session_started_ms;
+          this->burst_.cycle_started_ms = this->loop_state_.session_started_ms;
+          this->clear_values_();
+        }
+      }
+      if (!this->loop_state_.readout_fallback && this->time_sync_due_()) {
+        ESP_LOGD(TAG, "Meter clock check is due");
+        this->meter_->time_sync_pending = true;
+      }
+      this->loop_state_.readout = !this->loop_state_.readout_fallback && this->use_readout_();
       this->log_state_();
+      ESP_LOGD(TAG, "Opening session with meter '%s'%s", this->meter_->address,
+               this->loop_state_.readout ? " in data readout mode" : "");
 
       this->clear_rx_buffers_();
       if (this->are_baud_rates_different_()) {
@@ -288,14 +740,11 @@ void EnergomeraIecComponent::loop() {
         delay(5);
       }
 
-      uint8_t open_cmd[32]{0};
-      uint8_t open_cmd_len = snprintf((char *) open_cmd, 32, "/?%s!\r\n", this->meter_address_.c_str());
-      this->loop_state_.request_iter = this->sensors_.begin();
-      this->send_frame_(open_cmd, open_cmd_len);
+      this->start_request_cycle_();
+      this->send_frame_(this->meter_->open_cmd, this->meter_->open_cmd_size);
       this->set_next_state_(State::OPEN_SESSION_GET_ID);
-      auto read_fn = [this]() { return this->receive_frame_ascii_(); };
       // mission crit, no crc
-      this->read_reply_and_go_next_state_(read_fn, State::OPEN_SESSION_GET_ID, 0, true, false);
+      this->read_reply_and_go_next_state_(Reader::ASCII, State::OPEN_SESSION_GET_ID, 0, true, false);
 
     } break;
 
@@ -306,24 +755,35 @@ void EnergomeraIecComponent::loop() {
         char *id = this->extract_meter_id_(received_frame_size_);
         if (id == nullptr) {
           ESP_LOGE(TAG, "Invalid meter identification frame");
-          this->stats_.invalid_frames_++;
+          this->meter_->stats.invalid_frames_++;
           this->abort_mission_();
           return;
         }
+        if (strncmp(this->meter_->identity, id, sizeof(this->meter_->identity) - 1) != 0) {
+          strncpy(this->meter_->identity, id, sizeof(this->meter_->identity) - 1);
+          if (this->restore_value_)
+            this->meter_->identity_pref.save(&this->meter_->identity);
+          this->select_profile_();
+        }
+        this->apply_profile_();
 
         this->update_last_rx_time_();
-        if (this->are_baud_rates_different_()) {
+        if (this->loop_state_.readout) {
+          this->start_readout_();
+        } else if (this->are_baud_rates_different_()) {
           this->prepare_frame_(CMD_ACK_SET_BAUD_AND_MODE, sizeof(CMD_ACK_SET_BAUD_AND_MODE));
 
           this->buffers_.out[2] = baud_rate_to_byte(this->baud_rate_);  // set baud rate
           this->send_frame_prepared_();
-          this->flush();
-          this->set_next_state_delayed_(250, State::SET_BAUD);
+          this->transport_->flush();
+          this->set_next_state_(State::SET_BAUD);
 
         } else {
-          this->send_frame_(CMD_ACK_SET_BAUD_AND_MODE, sizeof(CMD_ACK_SET_BAUD_AND_MODE));
-          auto read_fn = [this]() { return this->receive_prog_frame_(SOH); };
-          this->read_reply_and_go_next_state_(read_fn, State::ACK_START_GET_INFO, 3, true, true);
+          // the meter stays at the handshake speed, which is not always the 9600 of the constant frame
+          this->prepare_frame_(CMD_ACK_SET_BAUD_AND_MODE, sizeof(CMD_ACK_SET_BAUD_AND_MODE));
+          this->buffers_.out[2] = baud_rate_to_byte(this->baud_rate_handshake_);
+          this->send_frame_prepared_();
+          this->read_reply_and_go_next_state_(Reader::PROG_SOH, State::ACK_START_GET_INFO, 3, true, true);
         }
       }
       break;
@@ -331,8 +791,13 @@ void EnergomeraIecComponent::loop() {
     case State::SET_BAUD:
       this->log_state_();
       this->update_last_rx_time_();
+      // the meter answers the ACK at the new speed already
       this->set_baud_rate_(this->baud_rate_);
-      this->set_next_state_delayed_(150, State::ACK_START_GET_INFO);
+      if (this->loop_state_.readout) {
+        this->set_next_state_(State::READOUT);
+      } else {
+        this->read_reply_and_go_next_state_(Reader::PROG_SOH, State::ACK_START_GET_INFO, 3, true, true);
+      }
       break;
 
     case State::ACK_START_GET_INFO:
@@ -340,22 +805,23 @@ void EnergomeraIecComponent::loop() {
 
       if (received_frame_size_ == 0) {
         ESP_LOGE(TAG, "No response from meter.");
-        this->stats_.invalid_frames_++;
+        this->meter_->stats.invalid_frames_++;
         this->abort_mission_();
         return;
       }
 
       if (!get_values_from_brackets_(in_param_ptr, vals)) {
         ESP_LOGE(TAG, "Invalid frame format: '%s'", in_param_ptr);
-        this->stats_.invalid_frames_++;
+        this->meter_->stats.invalid_frames_++;
         this->abort_mission_();
         return;
       }
 
       ESP_LOGD(TAG, "Meter address: %s", vals[0]);
+      this->loop_state_.session_open = true;
 
       // did we have a time correction request?
-      if (this->time_to_set_ != 0) {
+      if (this->meter_->time_sync_pending) {
         this->set_next_state_(State::GET_DATE);
       } else {
         this->set_next_state_(State::DATA_ENQ);
@@ -374,72 +840,43 @@ void EnergomeraIecComponent::loop() {
       //      this->prepare_prog_frame_("GROUP(DATE_()TIME_())");
       this->prepare_prog_frame_("DATE_()");
       this->send_frame_prepared_();
-      auto read_fn = [this]() { return this->receive_prog_frame_(STX); };
-      this->read_reply_and_go_next_state_(read_fn, State::GET_TIME, 3, false, true);
+      this->read_reply_and_go_next_state_(Reader::PROG_STX, State::GET_TIME, 3, false, true);
     } break;
 
     case State::GET_TIME: {
       this->log_state_();
       this->update_last_rx_time_();
-      // We receive either of the following:
-      //       0         1         2         3
-      //       01234567890123456789012345678901234567890
-      //  <STX>DATE_(5.30.05.25)<CR><LF><ETX><ACK> (22)     // ce207
-      //  <STX>DATE_(05.30.05.25)<CR><LF><ETX><ACK> (23)    // ce301, etc.
-      if (received_frame_size_ != 22 && received_frame_size_ != 23) {
+      if (!this->parse_meter_date_(in_param_ptr, received_frame_size_)) {
         // no data or something wrong. error or malformed response
         ESP_LOGE(TAG, "No response or wrong response from meter. Can't get date, skipping sync.");
-        this->stats_.invalid_frames_++;
+        this->meter_->stats.invalid_frames_++;
         this->set_next_state_(State::DATA_ENQ);
         return;
       }
-      // 2020-08-25 05:30:00
-      // copy date parts
-      // assume it is year 20xx.
-      size_t d = 23 - received_frame_size_;  // 23 - 22 = 1, 23 - 23 = 0
-      this->meter_datetime_str_[0] = '2';
-      this->meter_datetime_str_[1] = '0';  // year 20xx
-      this->meter_datetime_str_[2] = in_param_ptr[d + 15];
-      this->meter_datetime_str_[3] = in_param_ptr[d + 16];  // year 20xx
-      this->meter_datetime_str_[4] = '-';                   // separator
-      this->meter_datetime_str_[5] = in_param_ptr[d + 12];  // month
-      this->meter_datetime_str_[6] = in_param_ptr[d + 13];  // month
-      this->meter_datetime_str_[7] = '-';                   // separator
-      this->meter_datetime_str_[8] = in_param_ptr[d + 9];   // day
-      this->meter_datetime_str_[9] = in_param_ptr[d + 10];  // day
-      this->meter_datetime_str_[10] = ' ';                  // separator
-      this->meter_datetime_str_[11] = '\0';
 
       this->set_next_state_(State::CORRECT_TIME);
       this->prepare_prog_frame_("TIME_()");
       this->send_frame_prepared_();
-      auto read_fn = [this]() { return this->receive_prog_frame_(STX); };
-      this->read_reply_and_go_next_state_(read_fn, State::CORRECT_TIME, 3, false, true);
+      this->time_request_ms_ = millis();
+      this->read_reply_and_go_next_state_(Reader::PROG_STX, State::CORRECT_TIME, 3, false, true);
 
     } break;
 
     case State::CORRECT_TIME: {
       this->log_state_();
 
-      // do not care, not real point in this
-      // auto time_received_delay_ms = millis() - this->last_rx_time_;
+      uint32_t reply_ms = this->last_rx_time_;  // TIME_() reply complete
+      bool reply_retried = this->reading_state_.tries_counter > 0;
 
       this->update_last_rx_time_();
       this->set_next_state_(State::DATA_ENQ);
 
-      // here we expect to receive time in format HH:MM:SS
-      //      0         1         2         3
-      //      01234567890123456789012345678901234567890
-      // <STX>TIME_(23:40:10)<CR><LF><ETX><17> (20)
-
-      if (received_frame_size_ != 20) {
+      if (!this->parse_meter_time_(in_param_ptr, received_frame_size_)) {
         // no data or something wrong. error or malformed response
         ESP_LOGE(TAG, "No response or wrong response from meter. Can't get time, skipping sync.");
-        this->stats_.invalid_frames_++;
+        this->meter_->stats.invalid_frames_++;
         return;
       }
-      memcpy(this->meter_datetime_str_ + 11, in_param_ptr + 6, 8);  // copy HH:MM:SS
-      this->meter_datetime_str_[19] = '\0';                         // null-terminate the string
 
       ESPTime meter_datetime;
       meter_datetime.day_of_week = 1;
@@ -471,25 +908,30 @@ void EnergomeraIecComponent::loop() {
       meter_datetime.recalc_timestamp_local();
       if (num != 6) {
         ESP_LOGE(TAG, "Invalid time received from meter: %s %d", this->meter_datetime_str_, num);
-        this->stats_.invalid_frames_++;
+        this->meter_->stats.invalid_frames_++;
         return;
       }
 
       if (!meter_datetime.is_valid()) {
         ESP_LOGE(TAG, "Invalid time received from meter: %s", this->meter_datetime_str_);
-        this->stats_.invalid_frames_++;
+        this->meter_->stats.invalid_frames_++;
         return;
       }
 
-      // check if time is 2 mins before or after midnight, then skip correction, wait for next data request
-      // just to make sure we have proper date/time
-      if ((meter_datetime.hour == 0 && meter_datetime.minute < 2) ||
-          (meter_datetime.hour == 23 && meter_datetime.minute > 58)) {
-        ESP_LOGD(TAG, "Time is too close to midnight, skipping correction.");
+      // time_sync_pending stays, the next session checks again
+      if (is_near_midnight(meter_datetime)) {
+        ESP_LOGD(TAG, "Meter time is within %u min of midnight, clock check deferred", MIDNIGHT_GUARD_MIN);
         return;
       }
 
-      auto now_ms = millis();
+      if (reply_retried) {
+        ESP_LOGW(TAG, "TIME_() request was repeated, round trip unknown, skipping correction.");
+        return;
+      }
+
+      // true time is known at base_ms, the meter read its clock about half way through the round trip
+      uint32_t base_ts = this->time_to_set_;
+      uint32_t base_ms = this->time_to_set_requested_at_ms_;
 #ifdef USE_TIME
       if (this->time_source_ != nullptr) {
         auto tm = this->time_source_->now();
@@ -497,49 +939,44 @@ void EnergomeraIecComponent::loop() {
           ESP_LOGE(TAG, "Time sync requested, but time provider is not yet ready");
           return;
         }
-        this->time_to_set_ = this->time_source_->now().timestamp;
-        this->time_to_set_requested_at_ms_ = now_ms;
+        base_ts = tm.timestamp;
+        base_ms = millis();
       }
 #endif
-      // if we are here, we have a valid time
-      // find what is real time now
-      uint32_t ms_since_asked = now_ms - this->time_to_set_requested_at_ms_;
+      uint32_t rtt_ms = reply_ms - this->time_request_ms_;
+      int32_t read_to_base_ms = (int32_t) (this->time_request_ms_ + rtt_ms / 2 - base_ms);
+      double true_ts = base_ts + read_to_base_ms / 1000.0;
 
       meter_datetime.recalc_timestamp_local();
-      int32_t correction_seconds = (this->time_to_set_ + ms_since_asked / 1000) - meter_datetime.timestamp;
-
-      this->time_to_set_ = 0;
-      this->time_to_set_requested_at_ms_ = 0;
-
-      if (correction_seconds > -2 && correction_seconds < 2) {
-        ESP_LOGD(TAG, "No time correction needed (less than 2 seconds)");
-        return;
-      }
+      float offset_s = (float) (meter_datetime.timestamp - true_ts);
+      ESP_LOGD(TAG, "Meter clock is %+.1f s off, TIME_() round trip %u ms", offset_s, rtt_ms);
 
-      ESP_LOGD(TAG, "Time correction needed: %d seconds", correction_seconds);
+      this->meter_->time_sync_pending = false;
 
       constexpr int32_t SECONDS_IN_24H = 24 * 3600;
 
       // if correction is more than 24 hours,
       // it is serious meter failure, meter shall be replaced or time is completely wrong
-      if (correction_seconds > SECONDS_IN_24H || correction_seconds < -SECONDS_IN_24H) {
+      if (offset_s > SECONDS_IN_24H || offset_s < -SECONDS_IN_24H) {
         ESP_LOGE(TAG, "Time correction is more than 24 hours, meter is broken or time is completely wrong.");
         return;
       }
 
-      if (correction_seconds > 29) {
-        correction_seconds = 29;
-      } else if (correction_seconds < -29) {
-        correction_seconds = -29;
-      }
-      ESP_LOGD(TAG, "Setting time correction within +/- 29 seconds: %d", correction_seconds);
+      this->update_clock_model_(offset_s, true_ts);
+      uint32_t meter_day = meter_datetime.year * 10000 + meter_datetime.month * 100 + meter_datetime.day_of_month;
+      int32_t correction_seconds = this->plan_clock_correction_(offset_s, meter_day);
+      this->save_clock_model_();
+      if (correction_seconds == 0)
+        return;
+      ESP_LOGD(TAG, "Setting time correction within +/- %u seconds a day: %d", MAX_DAILY_CORRECTION_S,
+               correction_seconds);
+      this->correction_sent_s_ = correction_seconds;
 
       char set_time_cmd[16]{0};
       size_t len = snprintf(set_time_cmd, sizeof(set_time_cmd), "CTIME(%d)", correction_seconds);
       this->prepare_prog_frame_(set_time_cmd, true);
       this->send_frame_prepared_();
-      auto read_fn = [this]() { return this->receive_frame_ack_nack_(); };
-      this->read_reply_and_go_next_state_(read_fn, State::RECV_CORRECTION_RESULT, 0, false, false);
+      this->read_reply_and_go_next_state_(Reader::ACK_NACK, State::RECV_CORRECTION_RESULT, 0, false, false);
     } break;
 
     case State::RECV_CORRECTION_RESULT: {
@@ -548,12 +985,13 @@ void EnergomeraIecComponent::loop() {
 
       if (received_frame_size_ == 0) {
         ESP_LOGW(TAG, "No response from meter after time correction request. Not supported?");
-        this->stats_.invalid_frames_++;
+        this->meter_->stats.invalid_frames_++;
         return;
       }
       char reply = this->buffers_.in[0];
       if (reply == ACK) {
         ESP_LOGD(TAG, "Time correction acknowledged");
+        this->clock_corrected_(this->correction_sent_s_);
       } else if (reply == NAK) {
         ESP_LOGD(TAG, "Time correction declined");
       } else {
@@ -564,17 +1002,15 @@ void EnergomeraIecComponent::loop() {
 
     case State::DATA_ENQ:
       this->log_state_();
-      if (this->loop_state_.request_iter == this->sensors_.end()) {
+      if (this->loop_state_.request_iter == this->meter_->sensors.end()) {
         ESP_LOGD(TAG, "All requests done");
         this->set_next_state_(State::CLOSE_SESSION);
         break;
       } else {
-        auto req = this->loop_state_.request_iter->first;
-        ESP_LOGD(TAG, "Requesting data for '%s'", req.c_str());
-        this->prepare_prog_frame_(req.c_str());
-        this->send_frame_prepared_();
-        auto read_fn = [this]() { return this->receive_prog_frame_(STX); };
-        this->read_reply_and_go_next_state_(read_fn, State::DATA_RECV, 3, false, true);
+        const auto *sensor = this->loop_state_.request_iter->second;
+        ESP_LOGD(TAG, "Requesting data for '%s'", sensor->get_request().c_str());
+        this->send_frame_(sensor->get_frame(), sensor->get_frame_size());
+        this->read_reply_and_go_next_state_(Reader::PROG_STX, State::DATA_RECV, 3, false, true);
       }
       break;
 
@@ -589,12 +1025,12 @@ void EnergomeraIecComponent::loop() {
         return;
       }
 
-      auto req = this->loop_state_.request_iter->first;
+      const auto &req = this->loop_state_.request_iter->first;
 
       uint8_t brackets_found = get_values_from_brackets_(in_param_ptr, vals);
       if (!brackets_found) {
         ESP_LOGE(TAG, "Invalid frame format: '%s'", in_param_ptr);
-        this->stats_.invalid_frames_++;
+        this->meter_->stats.invalid_frames_++;
         return;
       }
 
@@ -618,17 +1054,25 @@ void EnergomeraIecComponent::loop() {
         return;
       }
 
-      auto range = sensors_.equal_range(req);
+      uint32_t read_ms = millis();
+      uint32_t timestamp = this->read_timestamp_();
+      auto range = this->meter_->sensors.equal_range(req);
       for (auto it = range.first; it != range.second; ++it) {
         if (!it->second->is_failed())
-          set_sensor_value_(it->second, vals);
+          this->set_sensor_value_(it->second, req.c_str(), vals, read_ms, timestamp);
       }
+      this->throughput_.requests++;
     } break;
 
     case State::DATA_NEXT:
       this->log_state_();
-      this->loop_state_.request_iter = this->sensors_.upper_bound(this->loop_state_.request_iter->first);
-      if (this->loop_state_.request_iter != this->sensors_.end()) {
+      this->advance_request_();
+      if (this->loop_state_.request_iter != this->meter_->sensors.end() && this->session_budget_exceeded_()) {
+        ESP_LOGW(TAG, "Session time budget exceeded, next session resumes from '%s'",
+                 this->loop_state_.request_iter->first.c_str());
+        this->meter_->resume_iter = this->loop_state_.request_iter;
+        this->set_next_state_delayed_(this->delay_between_requests_ms_, State::CLOSE_SESSION);
+      } else if (this->loop_state_.request_iter != this->meter_->sensors.end()) {
         this->set_next_state_delayed_(this->delay_between_requests_ms_, State::DATA_ENQ);
       } else {
         this->set_next_state_delayed_(this->delay_between_requests_ms_, State::CLOSE_SESSION);
@@ -637,11 +1081,16 @@ void EnergomeraIecComponent::loop() {
 
     case State::CLOSE_SESSION:
       this->log_state_();
-      ESP_LOGD(TAG, "Closing session");
-      this->send_frame_(CMD_CLOSE_SESSION, sizeof(CMD_CLOSE_SESSION));
+      if (this->burst_keeps_session_open_()) {
+        ESP_LOGD(TAG, "Burst mode, keeping session open");
+      } else {
+        ESP_LOGD(TAG, "Closing session");
+        this->send_frame_(CMD_CLOSE_SESSION, sizeof(CMD_CLOSE_SESSION));
+        this->loop_state_.session_open = false;
+      }
       this->set_next_state_(State::PUBLISH);
       ESP_LOGD(TAG, "Total connection time: %u ms", millis() - this->loop_state_.session_started_ms);
-      this->loop_state_.sensor_iter = this->sensors_.begin();
+      this->loop_state_.sensor_iter = this->meter_->sensors.begin();
       break;
 
     case State::PUBLISH:
@@ -649,20 +1098,49 @@ void EnergomeraIecComponent::loop() {
       ESP_LOGD(TAG, "Publishing data");
       this->update_last_rx_time_();
 
-      if (this->loop_state_.sensor_iter != this->sensors_.end()) {
-        this->loop_state_.sensor_iter->second->publish();
+      if (this->loop_state_.sensor_iter != this->meter_->sensors.end()) {
+        if (this->is_request_selected_(this->loop_state_.sensor_iter->first))
+          this->publish_sensor_(this->loop_state_.sensor_iter->second);
         this->loop_state_.sensor_iter++;
       } else {
         this->stats_dump_();
+        this->publish_restored_();
         if (this->crc_errors_per_session_sensor_ != nullptr) {
-          this->crc_errors_per_session_sensor_->publish_state(this->stats_.crc_errors_per_session());
+          // one sensor per component: counted over all meters, as they share the line
+          uint32_t errors = 0, sessions = 0;
+          for (const auto &meter : this->meters_) {
+            errors += meter.stats.crc_errors_;
+            sessions += meter.stats.connections_tried_;
+          }
+          this->crc_errors_per_session_sensor_->publish_state((float) errors / sessions);
         }
         this->report_failure(false);
-        this->unlock_uart_session_();
-        this->set_next_state_(State::IDLE);
+        this->throughput_.sessions++;
+        this->session_done_();
       }
       break;
 
+    case State::READOUT: {
+      this->log_state_();
+      int8_t result = this->receive_readout_();
+      // a noisy line keeps the RX timeout from ever expiring
+      bool over_budget = result == 0 && this->session_budget_exceeded_();
+      if (result == 0 && !over_budget && !this->check_rx_timeout_())
+        return;
+
+      if (over_budget) {
+        ESP_LOGW(TAG, "Data readout did not finish within the session budget.");
+        this->meter_->stats.invalid_frames_++;
+      } else if (result == 0) {
+        ESP_LOGW(TAG, "RX timeout during data readout.");
+        this->meter_->stats.invalid_frames_++;
+      } else if (result < 0) {
+        ESP_LOGW(TAG, "Data readout received, but CRC failed.");
+        this->meter_->stats.crc_errors_++;
+      }
+      this->readout_finished_(result > 0);
+    } break;
+
     case State::SINGLE_READ_ACK: {
       this->log_state_();
       if (received_frame_size_) {
@@ -678,24 +1156,829 @@ void EnergomeraIecComponent::loop() {
   }
 }
 
+#ifdef USE_ENERGOMERA_IEC_SOCKET
+// Between polls loop() is off, a client with bytes for the bus wakes it
+void EnergomeraIecComponent::bridge_listen_() {
+  if (this->state_ != State::IDLE)
+    return;  // loop() serves the bridge
+  this->bridge_->loop();
+  if (this->bridge_->pending() > 0)
+    this->wake_();
+}
+
+// Client waits for the end of our session, then keeps the bus until its traffic pauses for the idle timeout.
+// It is cut short only when it holds the bus past the max slot and a poll is waiting, ours or of another hub.
+void EnergomeraIecComponent::bridge_loop_() {
+  auto *bridge = this->bridge_.get();
+  bridge->loop();
+
+  if (this->state_ != State::BRIDGE) {
+    // polls waiting for the bus go first, or a busy client would take it back right after its slot
+    if (bridge->pending() == 0 || this->state_ != State::IDLE || this->is_bus_wanted_() ||
+        !this->try_lock_uart_session_())
+      return;
+    ESP_LOGD(TAG, "Bridge: bus handed to %s", bridge->get_client_name());
+    this->clear_rx_buffers_();
+    if (this->transport_->supports_baud_rate_change())
+      this->set_baud_rate_(this->baud_rate_handshake_);
+    this->bridge_slot_started_ms_ = millis();
+    this->set_next_state_(State::BRIDGE);
+  }
+
+  this->bridge_forward_();
+
+  uint32_t now = millis();
+  if (!bridge->has_client()) {
+    this->bridge_release_("client gone");
+  } else if (now - bridge->get_last_activity_ms() >= this->bridge_idle_timeout_ms_) {
+    this->bridge_release_("client idle");
+  } else if (now - this->bridge_slot_started_ms_ >= this->bridge_max_slot_ms_ && this->is_bus_wanted_()) {
+    this->bridge_release_("slot is over");
+  }
+}
+
+bool EnergomeraIecComponent::is_bus_wanted_() {
+  if (this->bridge_poll_pending_)
+    return true;
+  void *bus = this->bus_id_();
+  for (auto *other : instances_) {
+    if (other != this && other->bus_id_() == bus && other->is_waiting_for_bus_())
+      return true;
+  }
+  return false;
+}
+
+void EnergomeraIecComponent::bridge_forward_() {
+  auto *bridge = this->bridge_.get();
+  size_t len = bridge->pending();
+  if (len > 0) {
+    const uint8_t *data = bridge->pending_data();
+    this->send_frame_(data, len);
+    // "<ACK>0Z1<CR><LF>": the meter goes to Z speed, so do we
+    if (len == 6 && data[0] == ACK && data[4] == CR && data[5] == LF &&
+        this->transport_->supports_baud_rate_change()) {
+      uint32_t baud_rate = byte_to_baud_rate(data[2]);
+      if (baud_rate != 0 && baud_rate != this->baud_rate_handshake_) {
+        this->set_timeout("bridge_baud", 250, [this, baud_rate]() {
+          if (this->state_ == State::BRIDGE)
+            this->set_baud_rate_(baud_rate);
+        });
+      }
+    }
+    bridge->clear_pending();
+  }
+
+  uint8_t buf[64];
+  size_t received = 0;
+  int count = this->transport_->available();
+  while (count-- > 0 && received < sizeof(buf) && this->transport_->read_one_byte(&buf[received]))
+    received++;
+  if (received > 0) {
+    this->trace_frame_(FrameTrace::Direction::RX, buf, received);
+    bridge->send(buf, received);
+  }
+}
+
+void EnergomeraIecComponent::bridge_release_(const char *reason) {
+  uint32_t slot_ms = millis() - this->bridge_slot_started_ms_;
+  this->bridge_->slot_done(slot_ms);
+  ESP_LOGD(TAG, "Bridge: bus back after %u ms, %s", slot_ms, reason);
+  this->cancel_timeout("bridge_baud");
+  if (this->transport_->supports_baud_rate_change())
+    this->set_baud_rate_(this->baud_rate_handshake_);
+  this->clear_rx_buffers_();
+  this->unlock_uart_session_();
+  this->set_next_state_(State::IDLE);
+  if (this->bridge_poll_pending_) {
+    this->bridge_poll_pending_ = false;
+    this->start_poll_();
+  }
+}
+#endif
+
+// Leaving IDLE, may be called from outside of loop(): polling timer, burst, etc.
+void EnergomeraIecComponent::wake_() {
+  this->update_last_rx_time_();
+  this->loop_stats_.woken_ms = millis();
+  this->high_freq_.start();
+  this->enable_loop();
+}
+
+// Nothing to do until the next poll
+void EnergomeraIecComponent::sleep_() {
+  this->update_last_rx_time_();
+  this->loop_stats_.active_ms += millis() - this->loop_stats_.woken_ms;
+  this->high_freq_.stop();
+  // a pending poll waits in loop() for its moment, the bridge listener has its own interval
+  if (!this->poll_deadline_.pending)
+    this->disable_loop();
+}
+
 void EnergomeraIecComponent::update() {
+#ifdef USE_TIME
+  if (this->align_to_clock_ && this->get_update_interval() != SCHEDULER_DONT_RUN && this->schedule_aligned_poll_()) {
+    ESP_LOGD(TAG, "Time source is valid, polls are aligned to clock from now on");
+    return;
+  }
+#endif
+  uint32_t offset_ms = this->stagger_offset_ms_();
+  if (offset_ms == 0) {
+    this->start_poll_();
+    return;
+  }
+  ESP_LOGV(TAG, "Poll staggered by %u ms", offset_ms);
+  this->schedule_poll_(offset_ms);
+}
+
+void EnergomeraIecComponent::schedule_poll_(uint32_t delay_ms) {
+  this->poll_deadline_.at_ms = millis() + delay_ms;
+  this->poll_deadline_.pending = true;
+  this->enable_loop();
+}
+
+void EnergomeraIecComponent::check_poll_deadline_() {
+  if (!this->poll_deadline_.pending || (int32_t) (millis() - this->poll_deadline_.at_ms) < 0)
+    return;
+  this->poll_deadline_.pending = false;
+  this->start_poll_();
+#ifdef USE_TIME
+  if (this->poll_deadline_.aligned && !this->schedule_aligned_poll_()) {
+    ESP_LOGW(TAG, "Time source lost, back to polling every update interval");
+    this->poll_deadline_.aligned = false;
+    this->start_poller();
+  }
+#endif
+}
+
+void EnergomeraIecComponent::start_poll_() {
+  if (this->burst_.active) {
+    ESP_LOGV(TAG, "Burst mode is active, regular data collection postponed");
+    return;
+  }
+#ifdef USE_ENERGOMERA_IEC_SOCKET
+  if (this->state_ == State::BRIDGE) {
+    ESP_LOGD(TAG, "Bridge client has the bus, data collection postponed");
+    this->bridge_poll_pending_ = true;
+    return;
+  }
+#endif
   if (this->state_ != State::IDLE) {
     ESP_LOGD(TAG, "Starting data collection impossible - component not ready");
     return;
   }
+  if (this->recovery_.polls_to_skip > 0) {
+    this->recovery_.polls_to_skip--;
+    ESP_LOGD(TAG, "Meters keep failing, poll skipped");
+    return;
+  }
   ESP_LOGD(TAG, "Starting data collection");
   this->set_next_state_(State::TRY_LOCK_BUS);
 }
 
+#ifdef USE_TIME
+// Takes over from the polling timer: each poll schedules the next one at the following multiple of update interval
+bool EnergomeraIecComponent::schedule_aligned_poll_() {
+  auto now = this->time_source_->utcnow();
+  if (!now.is_valid()) {
+    return false;
+  }
+  uint32_t now_s = now.timestamp;
+  uint32_t interval_s = std::max<uint32_t>(this->get_update_interval() / 1000, 1);
+  uint32_t boundary = (now_s / interval_s + 1) * interval_s;
+  if (boundary <= this->last_aligned_boundary_) {
+    boundary = this->last_aligned_boundary_ + interval_s;
+  }
+  this->last_aligned_boundary_ = boundary;
+
+  uint32_t delay_ms = (boundary - now_s) * 1000 + this->stagger_offset_ms_();
+  ESP_LOGV(TAG, "Next aligned poll in %u ms", delay_ms);
+  if (!this->poll_deadline_.aligned) {
+    this->stop_poller();
+    this->poll_deadline_.aligned = true;
+  }
+  this->schedule_poll_(delay_ms);
+  return true;
+}
+#endif
+
+// Instances on the same bus spread their polls evenly over the update interval
+uint32_t EnergomeraIecComponent::stagger_offset_ms_() {
+  uint32_t interval = this->get_update_interval();
+  if (!this->stagger_ || interval == SCHEDULER_DONT_RUN)
+    return 0;
+
+  uint8_t slot = 0;
+  uint8_t count = 0;
+  for (auto *other : instances_) {
+    if (other->bus_id_() != this->bus_id_())
+      continue;
+    if (other == this)
+      slot = count;
+    count++;
+  }
+  if (count < 2)
+    return 0;
+  return interval / count * slot;
+}
+
+uint32_t EnergomeraIecComponent::read_timestamp_() {
+#ifdef USE_TIME
+  if (this->time_source_ != nullptr) {
+    auto now = this->time_source_->utcnow();
+    if (now.is_valid())
+      return now.timestamp;
+  }
+#endif
+  return 0;
+}
+
 void EnergomeraIecComponent::queue_single_read(const std::string &request) {
   ESP_LOGD(TAG, "Queueing single read for '%s'", request.c_str());
   this->single_requests_.push_back(request);
 }
 
-bool char2float(const char *str, float &value) {
-  char *end;
-  value = strtof(str, &end);
-  return *end == '\0';
+void EnergomeraIecComponent::start_burst(const std::vector<std::string> &requests, uint32_t duration_ms,
+                                         uint32_t interval_ms) {
+  this->burst_.requests.clear();
+  for (auto req : requests) {
+    if (req.find('(') == std::string::npos)
+      req += "()";
+    bool known = false;
+    for (const auto &meter : this->meters_) {
+      known = known || meter.sensors.count(req) > 0;
+    }
+    if (!known) {
+      ESP_LOGW(TAG, "Burst: no sensors for request '%s', ignoring", req.c_str());
+      continue;
+    }
+    this->burst_.requests.push_back(req);
+  }
+  if (this->burst_.requests.empty()) {
+    ESP_LOGE(TAG, "Burst: nothing to poll");
+    return;
+  }
+
+  this->burst_.duration_ms = duration_ms;
+  this->burst_.interval_ms = interval_ms;
+  if (this->state_ != State::IDLE) {
+    // a running cycle keeps its request set and counts as a regular one
+    ESP_LOGI(TAG, "Burst: starts when the current session is over");
+    this->burst_.pending = true;
+    return;
+  }
+  this->activate_burst_();
+}
+
+void EnergomeraIecComponent::activate_burst_() {
+  ESP_LOGI(TAG, "Burst: polling %u request(s) every %u ms for %u ms", (unsigned) this->burst_.requests.size(),
+           this->burst_.interval_ms, this->burst_.duration_ms);
+  this->burst_.pending = false;
+  this->burst_.active = true;
+  this->burst_.started_ms = millis();
+  this->burst_.cycle_started_ms = this->burst_.started_ms;
+  this->burst_.cycles = 0;
+  this->burst_.bus_busy_ms = 0;
+  this->set_next_state_(State::TRY_LOCK_BUS);
+}
+
+void EnergomeraIecComponent::stop_burst() {
+  if (this->burst_.pending) {
+    ESP_LOGI(TAG, "Burst: cancelled before it started");
+    this->burst_.pending = false;
+    return;
+  }
+  if (!this->burst_.active)
+    return;
+  ESP_LOGI(TAG, "Burst: stop requested");
+  this->burst_.duration_ms = 0;  // expires at the end of the current cycle
+  if (this->state_ == State::IDLE) {
+    // waiting between cycles with session closed
+    this->cancel_timeout("burst");
+    this->burst_.active = false;
+    this->set_next_state_(State::TRY_LOCK_BUS);
+  }
+}
+
+float EnergomeraIecComponent::get_burst_refresh_rate() const {
+  uint32_t elapsed_ms = millis() - this->burst_.started_ms;
+  if (!this->burst_.active || elapsed_ms == 0)
+    return 0.0f;
+  return this->burst_.cycles * 1000.0f / elapsed_ms;
+}
+
+float EnergomeraIecComponent::get_burst_bus_utilization() const {
+  uint32_t elapsed_ms = millis() - this->burst_.started_ms;
+  if (!this->burst_.active || elapsed_ms == 0)
+    return 0.0f;
+  return (float) this->burst_.bus_busy_ms / elapsed_ms;
+}
+
+uint32_t EnergomeraIecComponent::bus_held_ms_() const {
+  const auto &tp = this->throughput_;
+  return tp.bus_ms + (tp.locked ? millis() - tp.locked_ms : 0);
+}
+
+float EnergomeraIecComponent::get_sessions_per_hour() const {
+  uint32_t elapsed_ms = millis() - this->throughput_.started_ms;
+  if (elapsed_ms == 0)
+    return 0.0f;
+  return this->throughput_.sessions * 3600000.0f / elapsed_ms;
+}
+
+float EnergomeraIecComponent::get_ms_per_request() const {
+  if (this->throughput_.requests == 0)
+    return 0.0f;
+  return (float) this->bus_held_ms_() / this->throughput_.requests;
+}
+
+float EnergomeraIecComponent::get_bus_idle_fraction() {
+  uint32_t elapsed_ms = millis() - this->throughput_.started_ms;
+  if (elapsed_ms == 0)
+    return 1.0f;
+  uint32_t busy_ms = 0;
+  for (auto *other : instances_) {
+    if (other->bus_id_() == this->bus_id_())
+      busy_ms += other->bus_held_ms_();
+  }
+  return busy_ms >= elapsed_ms ? 0.0f : 1.0f - (float) busy_ms / elapsed_ms;
+}
+
+void EnergomeraIecComponent::dump_throughput() {
+  ESP_LOGI(TAG,
+           "{\"component\":\"%s\",\"uptime_s\":%u,\"baud_rate\":%u,\"meters\":%u,\"sessions\":%u,"
+           "\"sessions_per_hour\":%.1f,\"requests\":%u,\"ms_per_request\":%.1f,\"bus_idle\":%.3f,"
+           "\"lock_waits\":%u,\"lock_wait_ms\":%u,\"lock_wait_max_ms\":%u,\"starved\":%u}",
+           this->tag_, (millis() - this->throughput_.started_ms) / 1000, this->baud_rate_,
+           (unsigned) this->meters_.size(), this->throughput_.sessions, this->get_sessions_per_hour(),
+           this->throughput_.requests, this->get_ms_per_request(), this->get_bus_idle_fraction(),
+           this->lock_wait_.waits, this->lock_wait_.total_ms, this->lock_wait_.max_ms, this->lock_wait_.starved);
+}
+
+bool EnergomeraIecComponent::is_request_selected_(const std::string &req) const {
+  if (!this->burst_.active)
+    return true;
+  return std::find(this->burst_.requests.begin(), this->burst_.requests.end(), req) != this->burst_.requests.end();
+}
+
+SensorMap::iterator EnergomeraIecComponent::find_selected_request_(SensorMap::iterator from) {
+  auto it = from;
+  while (it != this->meter_->sensors.end() &&
+         (!this->is_request_selected_(it->first) || this->is_request_read_out_(it->first))) {
+    it = this->meter_->sensors.upper_bound(it->first);
+  }
+  return it;
+}
+
+bool EnergomeraIecComponent::burst_keeps_session_open_() const {
+  // the bus can only hold one session, so with several meters every cycle reopens them in turn
+  if (!this->burst_.active || this->burst_expired_() || this->meters_.size() > 1)
+    return false;
+  uint32_t cycle_ms = millis() - this->burst_.cycle_started_ms;
+  return cycle_ms + BURST_KEEP_SESSION_MAX_MS >= this->burst_.interval_ms;
+}
+
+// Meters are polled back-to-back while the bus stays locked, the lock is released after the last one
+void EnergomeraIecComponent::session_done_() {
+  this->loop_state_.readout = false;
+  this->loop_state_.readout_fallback = false;
+  if (this->meter_idx_ + 1u < this->meters_.size()) {
+    this->meter_ = &this->meters_[++this->meter_idx_];
+    this->set_next_state_delayed_(this->delay_between_requests_ms_, State::OPEN_SESSION);
+    return;
+  }
+  this->meter_idx_ = 0;
+  this->meter_ = &this->meters_[0];
+
+  if (this->burst_.active) {
+    this->burst_cycle_done_();
+    return;
+  }
+  this->unlock_uart_session_();
+  this->set_next_state_(State::IDLE);
+}
+
+void EnergomeraIecComponent::burst_cycle_done_() {
+  uint32_t now = millis();
+  uint32_t cycle_ms = now - this->burst_.cycle_started_ms;
+  this->burst_.cycles++;
+  this->burst_.bus_busy_ms += cycle_ms;
+  ESP_LOGD(TAG, "Burst: cycle %u took %u ms, refresh rate %.2f Hz, bus utilization %.0f%%", this->burst_.cycles,
+           cycle_ms, this->get_burst_refresh_rate(), this->get_burst_bus_utilization() * 100.0f);
+
+  if (this->burst_expired_()) {
+    ESP_LOGI(TAG, "Burst: finished after %u cycles, refresh rate %.2f Hz, bus utilization %.0f%%", this->burst_.cycles,
+             this->get_burst_refresh_rate(), this->get_burst_bus_utilization() * 100.0f);
+    this->burst_.active = false;
+    if (this->loop_state_.session_open) {
+      this->send_frame_(CMD_CLOSE_SESSION, sizeof(CMD_CLOSE_SESSION));
+      this->loop_state_.session_open = false;
+    }
+    this->unlock_uart_session_();
+    // full cycle straight away to refresh everything skipped during burst
+    this->set_next_state_(State::TRY_LOCK_BUS);
+    return;
+  }
+
+  uint32_t wait_ms = cycle_ms < this->burst_.interval_ms ? this->burst_.interval_ms - cycle_ms : 0;
+  if (this->loop_state_.session_open) {
+    this->start_request_cycle_();
+    this->clear_values_();
+    this->burst_.cycle_started_ms = now + wait_ms;
+    this->set_next_state_delayed_(wait_ms, State::DATA_ENQ);
+    return;
+  }
+
+  this->unlock_uart_session_();
+  this->set_next_state_(State::IDLE);
+  this->set_timeout("burst", wait_ms, [this]() {
+    if (this->state_ == State::IDLE)
+      this->set_next_state_(State::TRY_LOCK_BUS);
+  });
+}
+
+uint32_t EnergomeraIecComponent::get_request_value_age_ms(const std::string &req) {
+  uint32_t age = UINT32_MAX;
+  for (auto &meter : this->meters_) {
+    auto range = meter.sensors.equal_range(req);
+    for (auto it = range.first; it != range.second; ++it) {
+      age = std::min(age, it->second->get_value_age_ms());
+    }
+  }
+  return age;
+}
+
+// Burst polls a few requests as fast as possible, a full readout would only slow it down
+// Readout is of no use when a programming mode session is needed after it anyway. Its content can be changed
+// in the meter settings though, so one that missed requests is tried again every READOUT_REPROBE_SESSIONS.
+bool EnergomeraIecComponent::use_readout_() {
+  if (!this->readout_ || this->burst_.active || this->meter_->readout_failures >= READOUT_MAX_FAILURES)
+    return false;
+  if (this->meter_->readout_misses == 0)
+    return true;
+  if (++this->meter_->readout_skipped < READOUT_REPROBE_SESSIONS)
+    return false;
+  this->meter_->readout_skipped = 0;
+  return true;
+}
+
+void EnergomeraIecComponent::start_readout_() {
+  this->readout_state_ = {};
+  this->readout_state_.timestamp = this->read_timestamp_();
+  this->loop_state_.readout_started_ms = millis();
+  this->buffers_.amount_in = 0;
+
+  if (this->are_baud_rates_different_()) {
+    this->prepare_frame_(CMD_ACK_READOUT, sizeof(CMD_ACK_READOUT));
+    this->buffers_.out[2] = baud_rate_to_byte(this->baud_rate_);  // set baud rate
+    this->send_frame_prepared_();
+    this->transport_->flush();
+    this->set_next_state_(State::SET_BAUD);
+  } else {
+    this->prepare_frame_(CMD_ACK_READOUT, sizeof(CMD_ACK_READOUT));
+    this->buffers_.out[2] = baud_rate_to_byte(this->baud_rate_handshake_);
+    this->send_frame_prepared_();
+    this->set_next_state_(State::READOUT);
+  }
+}
+
+// Readout is one "<STX>NAME(value)<CR><LF>...!<CR><LF><ETX><BCC>" block, much bigger than the input buffer,
+// so datasets are parsed one by one as they come in. Values are staged until the BCC at the very end is known.
+// Returns 1 when the block is complete and BCC matches, -1 on BCC mismatch, 0 while more is to come.
+int8_t EnergomeraIecComponent::receive_readout_() {
+  using Stage = decltype(this->readout_state_.stage);
+  const uint32_t read_time_limit_ms = 25;
+  auto &ro = this->readout_state_;
+
+  int count = this->transport_->available();
+  uint32_t read_start = millis();
+  uint8_t b;
+  while (count-- > 0 && millis() - read_start <= read_time_limit_ms) {
+    if (!this->transport_->read_one_byte(&b))
+      break;
+    this->update_last_rx_time_();
+
+    switch (ro.stage) {
+      case Stage::WAIT_STX:
+        if (b == STX) {
+          ro.stage = Stage::DATA;
+          ro.line_start = true;
+        }
+        break;
+
+      case Stage::DATA:
+        ro.bcc = (ro.bcc + b) & 0x7f;
+        if (b == ETX || b == CR || b == LF) {
+          // "!" and such, a line without values
+          if (ro.name_pending)
+            this->buffers_.amount_in = ro.line_offset;
+          ro.name_pending = false;
+        }
+        if (b == ETX) {
+          this->process_readout_dataset_();
+          ro.stage = Stage::BCC;
+        } else if (b == CR || b == LF) {
+          ro.line_start = true;
+        } else {
+          // "NAME(v1)<CR><LF>(v2)<CR><LF>" continues the dataset of the previous line, and so does
+          // "NAME(v1)<CR><LF>NAME(v2)<CR><LF>" of CE301/CE303, which is only known once the name is complete
+          if (ro.line_start && b != '(') {
+            if (ro.overflow || this->buffers_.amount_in == 0) {
+              this->process_readout_dataset_();
+            } else {
+              ro.name_pending = true;
+              ro.line_offset = this->buffers_.amount_in;
+            }
+          } else if (ro.name_pending && b == '(') {
+            ro.name_pending = false;
+            this->split_readout_dataset_();
+          }
+          ro.line_start = false;
+          if (this->buffers_.amount_in < MAX_IN_BUF_SIZE - 1) {
+            this->buffers_.in[this->buffers_.amount_in++] = b;
+          } else {
+            ro.overflow = true;
+          }
+        }
+        break;
+
+      case Stage::BCC:
+        if (this->trace_.enabled()) {
+          uint8_t tail[] = {ETX, b};
+          this->trace_frame_(FrameTrace::Direction::RX, tail, sizeof(tail),
+                             b == ro.bcc ? FrameTrace::Check::BCC_OK : FrameTrace::Check::BCC_FAILED);
+        }
+        return b == ro.bcc ? 1 : -1;
+    }
+    yield();
+    App.feed_wdt();
+  }
+  return 0;
+}
+
+void EnergomeraIecComponent::process_readout_dataset_() {
+  auto &ro = this->readout_state_;
+  size_t size = this->buffers_.amount_in;
+  this->buffers_.amount_in = 0;
+  if (size == 0)
+    return;
+  if (ro.overflow) {
+    ro.overflow = false;
+    ESP_LOGW(TAG, "Data readout: dataset longer than %u bytes skipped", (unsigned) MAX_IN_BUF_SIZE);
+    this->meter_->stats.invalid_frames_++;
+    return;
+  }
+  this->buffers_.in[size] = '\0';
+  this->trace_frame_(FrameTrace::Direction::RX, this->buffers_.in, size);
+  char *name = (char *) this->buffers_.in;
+  ValueRefsArray vals;
+  uint8_t values_found = this->get_values_from_brackets_(name, vals);
+  if (values_found == 0)
+    return;  // "!" end of data and such
+  ro.datasets++;
+  for (uint8_t i = 0; i < values_found; i++) {
+    char *unit = strchr(vals[i], '*');  // "123.4*kWh"
+    if (unit != nullptr)
+      *unit = '\0';
+  }
+  ESP_LOGV(TAG, "Data readout: '%s', values: %u", name, values_found);
+
+  char req[24];
+  if (!make_request(req, sizeof(req), name)) {
+    ESP_LOGV(TAG, "Data readout: name '%s' is too long for a request", name);
+    return;
+  }
+  if (this->meter_->sensors.count(req) == 0)
+    return;
+  // name and values again, units stripped, for get_values_from_brackets_() to take apart later
+  char *stage = this->readout_staged_ + ro.staged_size;
+  size_t room = READOUT_STAGE_SIZE - ro.staged_size;
+  size_t len = snprintf(stage, room, "%s", name);
+  for (uint8_t i = 0; i < values_found && len < room; i++)
+    len += snprintf(stage + len, room - len, "(%s)", vals[i]);
+  if (len >= room) {
+    // its sensors are not fresh after the readout, programming mode reads them
+    ESP_LOGV(TAG, "Data readout: no room to stage '%s'", name);
+    return;
+  }
+  ro.staged_size += len + 1;
+}
+
+// The line at line_offset starts a new dataset, unless it repeats the name of the one before it
+void EnergomeraIecComponent::split_readout_dataset_() {
+  auto &ro = this->readout_state_;
+  char *in = (char *) this->buffers_.in;
+  size_t name_len = this->buffers_.amount_in - ro.line_offset;
+  if (name_len < ro.line_offset && in[name_len] == '(' && memcmp(in, in + ro.line_offset, name_len) == 0)
+    return;
+
+  char name[24];
+  bool fits = name_len < sizeof(name);
+  if (fits)
+    memcpy(name, in + ro.line_offset, name_len);
+  this->buffers_.amount_in = ro.line_offset;
+  this->process_readout_dataset_();
+  if (!fits) {
+    ro.overflow = true;
+    return;
+  }
+  memcpy(in, name, name_len);
+  this->buffers_.amount_in = name_len;
+}
+
+void EnergomeraIecComponent::apply_readout_() {
+  auto &ro = this->readout_state_;
+  ValueRefsArray vals;
+  char *entry = this->readout_staged_;
+  char *end = this->readout_staged_ + ro.staged_size;
+  while (entry < end) {
+    size_t len = strlen(entry);
+    this->get_values_from_brackets_(entry, vals);
+    char req[24];
+    if (!make_request(req, sizeof(req), entry)) {
+      entry += len + 1;
+      continue;  // not staged, process_readout_dataset_() checked it
+    }
+    this->throughput_.requests++;
+    auto range = this->meter_->sensors.equal_range(req);
+    for (auto it = range.first; it != range.second; ++it) {
+      // all values of the block count as read when it started
+      if (!it->second->is_failed() &&
+          this->set_sensor_value_(it->second, req, vals, this->loop_state_.readout_started_ms, ro.timestamp))
+        ro.values++;
+    }
+    entry += len + 1;
+  }
+  ro.staged_size = 0;
+}
+
+// The meter ends the session after the readout, whatever it did not cover is read in a new one
+// Values of a broken block are dropped, all requests are then read in programming mode.
+void EnergomeraIecComponent::readout_finished_(bool ok) {
+  auto &ls = this->loop_state_;
+  auto &ro = this->readout_state_;
+  if (ok) {
+    this->apply_readout_();
+    ESP_LOGD(TAG, "Data readout: %u datasets, %u values used, %u ms", ro.datasets, ro.values,
+             millis() - ls.readout_started_ms);
+    this->meter_->readout_failures = 0;
+  } else if (++this->meter_->readout_failures >= READOUT_MAX_FAILURES) {
+    ESP_LOGW(TAG, "Data readout failed %u times in a row, meter '%s' is read in programming mode only",
+             this->meter_->readout_failures, this->meter_->address);
+  }
+  if (!ok)
+    ro.staged_size = 0;
+  this->clear_rx_buffers_();
+
+  ls.readout = false;
+  ls.readout_fallback = true;
+  if (ok) {
+    this->meter_->readout_misses = this->count_requests_not_read_out_();
+    if (this->meter_->readout_misses > 0) {
+      ESP_LOGI(TAG, "Data readout of meter '%s' misses %u request(s), it is read in programming mode for %u sessions",
+               this->meter_->address, this->meter_->readout_misses, READOUT_REPROBE_SESSIONS);
+    }
+  }
+  this->start_request_cycle_();
+  if (ls.request_iter != this->meter_->sensors.end() || this->meter_->time_sync_pending) {
+    ESP_LOGD(TAG, "Reading the rest in programming mode");
+    this->set_next_state_delayed_(READOUT_REOPEN_DELAY_MS, State::OPEN_SESSION);
+    return;
+  }
+  ESP_LOGD(TAG, "Total connection time: %u ms", millis() - ls.session_started_ms);
+  ls.sensor_iter = this->meter_->sensors.begin();
+  this->set_next_state_(State::PUBLISH);
+}
+
+uint8_t EnergomeraIecComponent::count_requests_not_read_out_() {
+  uint8_t misses = 0;
+  auto &sensors = this->meter_->sensors;
+  for (auto it = sensors.begin(); it != sensors.end(); it = sensors.upper_bound(it->first)) {
+    if (this->is_request_read_out_(it->first))
+      continue;
+    ESP_LOGD(TAG, "Data readout has no '%s'", it->first.c_str());
+    misses++;
+  }
+  return misses;
+}
+
+// All values of the request came with the readout of this session
+bool EnergomeraIecComponent::is_request_read_out_(const std::string &req) {
+  if (!this->loop_state_.readout_fallback)
+    return false;
+  uint32_t since_readout_ms = millis() - this->loop_state_.readout_started_ms;
+  auto range = this->meter_->sensors.equal_range(req);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second->get_value_age_ms() > since_readout_ms)
+      return false;
+  }
+  return true;
+}
+
+// Regular cycles resume where the previous session ran out of time budget, burst cycles always start from the top
+void EnergomeraIecComponent::start_request_cycle_() {
+  auto &ls = this->loop_state_;
+  auto &sensors = this->meter_->sensors;
+  ls.request_iter = this->find_selected_request_(this->burst_.active ? sensors.begin() : this->meter_->resume_iter);
+  if (ls.request_iter == sensors.end() && this->meter_->resume_iter != sensors.begin()) {
+    ls.request_iter = this->find_selected_request_(sensors.begin());
+  }
+  ls.first_request_iter = ls.request_iter;
+  ls.wrapped = false;
+}
+
+void EnergomeraIecComponent::advance_request_() {
+  auto &ls = this->loop_state_;
+  auto &sensors = this->meter_->sensors;
+  auto it = this->find_selected_request_(sensors.upper_bound(ls.request_iter->first));
+  if (it == sensors.end() && !ls.wrapped && ls.first_request_iter != sensors.begin()) {
+    ls.wrapped = true;
+    it = this->find_selected_request_(sensors.begin());
+  }
+  if (ls.wrapped && it != sensors.end() && it->first >= ls.first_request_iter->first) {
+    it = sensors.end();  // went full circle
+  }
+  ls.request_iter = it;
+}
+
+bool EnergomeraIecComponent::session_budget_exceeded_() {
+  if (this->burst_.active)
+    return false;
+  uint32_t budget_ms = this->session_budget_ms_;
+  if (budget_ms == 0) {
+    // leave room for closing the session and publishing before the next update
+    budget_ms = this->get_update_interval() / 10 * 8;
+  }
+  // the budget is for all meters together, each gets its share plus what the previous ones left unused
+  uint32_t until_ms = (uint64_t) budget_ms * (this->meter_idx_ + 1) / this->meters_.size();
+  return millis() - this->loop_state_.cycle_started_ms >= until_ms;
+}
+
+bool EnergomeraIecComponent::is_link_up_() {
+#ifdef USE_API
+  if (api::global_api_server != nullptr && api::global_api_server->is_connected())
+    return true;
+#endif
+#ifdef USE_MQTT
+  if (mqtt::global_mqtt_client != nullptr && mqtt::global_mqtt_client->is_connected())
+    return true;
+#endif
+#if defined(USE_API) || defined(USE_MQTT)
+  return false;
+#else
+  return true;
+#endif
+}
+
+// Numeric readings go through the buffer while the link is down and until it is drained, to keep them in order.
+// Derived sensors follow their source. Samples of an aggregated sensor stay on the device unless asked for.
+void EnergomeraIecComponent::publish_sensor_(EnergomeraIecSensorBase *sensor) {
+  if (sensor->get_type() == SensorType::SENSOR_GROUP) {
+    for (auto *member : static_cast<EnergomeraIecSensorGroup *>(sensor)->get_sensors()) {
+      this->publish_sensor_(member);
+    }
+    return;
+  }
+  // not read in this cycle: the last published value, or the restored one, stays as it is
+  if (!sensor->has_value())
+    return;
+  if (sensor->get_type() != SensorType::SENSOR) {
+    sensor->publish();
+    return;
+  }
+  auto *numeric = static_cast<EnergomeraIecSensor *>(sensor);
+  numeric->save_value();
+  if (numeric->get_publish_samples()) {
+    if (!this->reading_buffer_.enabled() || (this->reading_buffer_.empty() && this->is_link_up_())) {
+      numeric->publish();
+    } else {
+      this->reading_buffer_.push(numeric, numeric->get_value(), millis(), numeric->get_timestamp());
+    }
+  }
+  for (auto *derived : numeric->get_derived()) {
+    if (derived->take_pending())
+      this->publish_sensor_(derived);
+  }
+}
+
+void EnergomeraIecComponent::drain_reading_buffer_() {
+  if (this->reading_buffer_.empty() || !this->is_link_up_())
+    return;
+
+  uint32_t now = millis();
+  for (uint8_t i = 0; i < BUFFER_DRAIN_BATCH && !this->reading_buffer_.empty(); i++) {
+    auto entry = this->reading_buffer_.pop();
+    uint32_t retention_ms = entry.sensor->get_retention_ms();
+    if (retention_ms > 0 && now - entry.read_ms > retention_ms) {
+      this->readings_expired_++;
+      continue;
+    }
+    // on_value sees the time the value was read, not when it is sent
+    entry.sensor->set_timestamp(entry.timestamp);
+    entry.sensor->publish_state(entry.value);
+  }
+  if (this->reading_buffer_.empty()) {
+    ESP_LOGD(TAG, "Buffered readings delivered");
+  }
 }
 
 #ifdef USE_TIME
@@ -719,27 +2002,127 @@ void EnergomeraIecComponent::set_device_time(uint32_t timestamp) {
     return;
   this->time_to_set_ = timestamp;
   this->time_to_set_requested_at_ms_ = millis();
+  for (auto &meter : this->meters_) {
+    meter.time_sync_pending = true;
+  }
+}
+
+// Drift is learned from how the offset changed since the baseline check, corrections in between excluded
+void EnergomeraIecComponent::update_clock_model_(float offset_s, double true_ts) {
+  auto &clock = this->meter_->clock;
+  clock.checked_ts = (uint32_t) true_ts;
+  clock.offset_s = offset_s;
+  if (clock.baseline_ts == 0) {
+    clock.baseline_ts = clock.checked_ts;
+    clock.baseline_offset_s = offset_s;
+    return;
+  }
+  float days = (float) (true_ts - clock.baseline_ts) / 86400.0f;
+  if (days < MIN_DRIFT_INTERVAL_DAYS)
+    return;
+  float drift = (offset_s - clock.baseline_offset_s) / days;
+  clock.drift_s_per_day =
+      clock.drift_known ? clock.drift_s_per_day + (drift - clock.drift_s_per_day) * DRIFT_SMOOTHING : drift;
+  clock.drift_known = true;
+  clock.baseline_ts = clock.checked_ts;
+  clock.baseline_offset_s = offset_s;
+  ESP_LOGD(TAG, "Meter clock drift: %+.2f s/day", clock.drift_s_per_day);
+}
+
+// What is left of the daily limit goes now, the rest in the following days
+int32_t EnergomeraIecComponent::plan_clock_correction_(float offset_s, uint32_t meter_day) {
+  auto &clock = this->meter_->clock;
+  if (clock.budget_day != meter_day) {
+    clock.budget_day = meter_day;
+    clock.corrected_s = 0;
+  }
+  if (fabsf(offset_s) < MIN_CLOCK_CORRECTION_S) {
+    ESP_LOGD(TAG, "No time correction needed (less than %.0f seconds)", MIN_CLOCK_CORRECTION_S);
+    return 0;
+  }
+  int32_t left = MAX_DAILY_CORRECTION_S - clock.corrected_s;
+  if (left <= 0) {
+    ESP_LOGD(TAG, "Daily time correction limit used up, continuing tomorrow");
+    return 0;
+  }
+  int32_t correction = -lroundf(offset_s);
+  return std::max(-left, std::min(left, correction));
+}
+
+void EnergomeraIecComponent::clock_corrected_(int32_t correction_s) {
+  auto &clock = this->meter_->clock;
+  clock.corrected_s += abs(correction_s);
+  clock.offset_s += correction_s;
+  clock.baseline_offset_s += correction_s;
+  if (fabsf(clock.offset_s) >= MIN_CLOCK_CORRECTION_S)
+    ESP_LOGD(TAG, "Meter clock still %+.1f s off, next step on the next day", clock.offset_s);
+  this->save_clock_model_();
+}
+
+// Drift takes days to learn, a reboot should not start it over
+void EnergomeraIecComponent::save_clock_model_() {
+  if (this->restore_value_)
+    this->meter_->clock_pref.save(&this->meter_->clock);
+}
+
+// Reading DATE_/TIME_ costs two exchanges, so with auto_time_sync it happens only when the model predicts
+// the offset is worth a correction, or once a day to keep the drift estimate fresh
+bool EnergomeraIecComponent::time_sync_due_() {
+#ifdef USE_TIME
+  if (!this->auto_time_sync_ || this->time_source_ == nullptr)
+    return false;
+  auto now = this->time_source_->now();
+  if (!now.is_valid() || is_near_midnight(now))
+    return false;
+  auto &clock = this->meter_->clock;
+  if (clock.checked_ts == 0)
+    return true;
+  float days = (float) (now.timestamp - clock.checked_ts) / 86400.0f;
+  if (days >= 1.0f)
+    return true;
+  float predicted_s = clock.offset_s + (clock.drift_known ? clock.drift_s_per_day * days : 0.0f);
+  if (fabsf(predicted_s) < MIN_CLOCK_CORRECTION_S)
+    return false;
+  // local date of the RTC is the meter date, close enough for the daily limit
+  uint32_t today = now.year * 10000 + now.month * 100 + now.day_of_month;
+  return clock.budget_day != today || clock.corrected_s < MAX_DAILY_CORRECTION_S;
+#else
+  return false;
+#endif
 }
 
-bool EnergomeraIecComponent::set_sensor_value_(EnergomeraIecSensorBase *sensor, ValueRefsArray &vals) {
+bool EnergomeraIecComponent::set_sensor_value_(EnergomeraIecSensorBase *sensor, const char *req,
+                                                ValueRefsArray &vals, uint32_t read_ms, uint32_t timestamp) {
   auto type = sensor->get_type();
   bool ret = true;
 
+  if (type == SensorType::SENSOR_GROUP) {
+    auto *group = static_cast<EnergomeraIecSensorGroup *>(sensor);
+    ret = false;
+    for (auto *member : group->get_sensors()) {
+      ret |= this->set_sensor_value_(member, req, vals, read_ms, timestamp);
+    }
+    if (ret) {
+      group->set_read_time(read_ms, timestamp);
+      group->values_updated();
+    }
+    return ret;
+  }
+
   uint8_t idx = sensor->get_index() - 1;
   if (idx >= VAL_NUM) {
     ESP_LOGE(TAG, "Invalid sensor index %u", idx);
     return false;
   }
   char str_buffer[128] = {'\0'};
-  strncpy(str_buffer, vals[idx], 128);
+  strncpy(str_buffer, vals[idx], sizeof(str_buffer) - 1);
 
   char *str = str_buffer;
   uint8_t sub_idx = sensor->get_sub_index();
   if (sub_idx == 0) {
-    ESP_LOGD(TAG, "Setting value for sensor '%s', idx = %d to '%s'", sensor->get_request().c_str(), idx + 1, str);
+    ESP_LOGD(TAG, "Setting value for sensor '%s', idx = %d to '%s'", req, idx + 1, str);
   } else {
-    ESP_LOGD(TAG, "Extracting value for sensor '%s', idx = %d, sub_idx = %d from '%s'", sensor->get_request().c_str(),
-             idx + 1, sub_idx, str);
+    ESP_LOGD(TAG, "Extracting value for sensor '%s', idx = %d, sub_idx = %d from '%s'", req, idx + 1, sub_idx, str);
     str = this->get_nth_value_from_csv_(str, sub_idx);
     if (str == nullptr) {
       ESP_LOGE(TAG,
@@ -753,15 +2136,18 @@ bool EnergomeraIecComponent::set_sensor_value_(EnergomeraIecSensorBase *sensor,
   }
 
   if (type == SensorType::SENSOR) {
-    float f = 0;
-    ret = str && str[0] && char2float(str, f);
+    Decimal value;
+    ret = str && str[0] && Decimal::parse(str, value);
     if (ret) {
-      static_cast<EnergomeraIecSensor *>(sensor)->set_value(f);
+      // derived sensors take the read time when the value is set
+      sensor->set_read_time(read_ms, timestamp);
+      static_cast<EnergomeraIecSensor *>(sensor)->set_value(value);
     } else {
       ESP_LOGE(TAG, "Cannot convert incoming data to a number. Consider using a text sensor. Invalid data: '%s'", str);
     }
   } else {
 #ifdef USE_TEXT_SENSOR
+    sensor->set_read_time(read_ms, timestamp);
     static_cast<EnergomeraIecTextSensor *>(sensor)->set_value(str);
 #endif
   }
@@ -799,10 +2185,10 @@ void EnergomeraIecComponent::set_next_state_delayed_(uint32_t ms, State next_sta
   }
 }
 
-void EnergomeraIecComponent::read_reply_and_go_next_state_(ReadFunction read_fn, State next_state, uint8_t retries,
+void EnergomeraIecComponent::read_reply_and_go_next_state_(Reader reader, State next_state, uint8_t retries,
                                                            bool mission_critical, bool check_crc) {
   reading_state_ = {};
-  reading_state_.read_fn = read_fn;
+  reading_state_.reader = reader;
   reading_state_.mission_critical = mission_critical;
   reading_state_.tries_max = retries;
   reading_state_.tries_counter = 0;
@@ -813,12 +2199,43 @@ void EnergomeraIecComponent::read_reply_and_go_next_state_(ReadFunction read_fn,
   set_next_state_(State::WAITING_FOR_RESPONSE);
 }
 
+// R1 frames of configured requests never change, so they are encoded once into one contiguous table.
+// Sensors sharing a request, even of different meters, point to the same frame.
+void EnergomeraIecComponent::build_frame_table_() {
+  struct Span {
+    size_t offset;
+    size_t size;
+  };
+  std::map<std::string, Span> spans;
+  for (auto &meter : this->meters_) {
+    for (auto &kv : meter.sensors) {
+      if (spans.count(kv.first))
+        continue;
+      this->prepare_prog_frame_(kv.first.c_str());
+      spans[kv.first] = {this->frame_table_.size(), this->buffers_.amount_out};
+      this->frame_table_.insert(this->frame_table_.end(), this->buffers_.out,
+                                this->buffers_.out + this->buffers_.amount_out);
+    }
+  }
+  this->frame_table_.shrink_to_fit();
+
+  // table does not move from now on
+  for (auto &meter : this->meters_) {
+    for (auto &kv : meter.sensors) {
+      const auto &span = spans[kv.first];
+      kv.second->set_frame(&this->frame_table_[span.offset], span.size);
+    }
+  }
+  ESP_LOGD(TAG, "Request frames: %u, %u bytes", (unsigned) spans.size(), (unsigned) this->frame_table_.size());
+}
+
 void EnergomeraIecComponent::prepare_prog_frame_(const char *request, bool write) {
   // we assume request has format "XXXX(params)"
   // we assume it always has brackets
   this->buffers_.amount_out = snprintf((char *) this->buffers_.out, MAX_OUT_BUF_SIZE, "%c%c1%c%s%c\xFF", SOH,
                                        (write ? 'W' : 'R'), STX, request, ETX);
   this->calculate_crc_prog_frame_(this->buffers_.out, this->buffers_.amount_out, true);
+  this->buffers_.tx = this->buffers_.out;
 }
 
 void EnergomeraIecComponent::prepare_non_session_prog_frame_(const char *request) {
@@ -829,11 +2246,12 @@ void EnergomeraIecComponent::prepare_non_session_prog_frame_(const char *request
   // "/?<address>!<SOH>R1<STX>NAME()<ETX><BCC>" direct
 
   this->buffers_.amount_out = snprintf((char *) this->buffers_.out, MAX_OUT_BUF_SIZE, "/?%s!%cR1%c%s%c\xFF",
-                                       this->meter_address_.c_str(), SOH, STX, request, ETX);
+                                       this->meter_->address, SOH, STX, request, ETX);
   // find SOH
   uint8_t *r1_ptr = std::find(this->buffers_.out, this->buffers_.out + this->buffers_.amount_out, SOH);
   size_t r1_size = r1_ptr - this->buffers_.out;
   calculate_crc_prog_frame_(r1_ptr, this->buffers_.amount_out - r1_size, true);
+  this->buffers_.tx = this->buffers_.out;
 }
 
 void EnergomeraIecComponent::prepare_ctime_frame_(uint8_t hh, uint8_t mm, uint8_t ss) {
@@ -842,37 +2260,59 @@ void EnergomeraIecComponent::prepare_ctime_frame_(uint8_t hh, uint8_t mm, uint8_
 
   this->buffers_.amount_out =
       snprintf((char *) this->buffers_.out, MAX_OUT_BUF_SIZE, "/?CTIME(%02d:%02d:%02d)!\r\n", hh, mm, ss);
+  this->buffers_.tx = this->buffers_.out;
 }
 
 void EnergomeraIecComponent::send_frame_prepared_() {
   if (this->flow_control_pin_ != nullptr)
     this->flow_control_pin_->digital_write(true);
 
-  this->write_array(this->buffers_.out, this->buffers_.amount_out);
-  this->flush();
+  this->transport_->write_array(this->buffers_.tx, this->buffers_.amount_out);
+  this->transport_->flush();
+  this->update_last_rx_time_();  // reply timeout runs from the end of the request
+  this->trace_frame_(FrameTrace::Direction::TX, this->buffers_.tx, this->buffers_.amount_out);
 
   if (this->flow_control_pin_ != nullptr)
     this->flow_control_pin_->digital_write(false);
 
-  ESP_LOGV(TAG, "TX: %s", format_frame_pretty(this->buffers_.out, this->buffers_.amount_out).c_str());
-  ESP_LOGVV(TAG, "TX: %s", format_hex_pretty(this->buffers_.out, this->buffers_.amount_out).c_str());
+  ESP_LOGV(TAG, "TX: %s", format_frame_pretty(this->buffers_.tx, this->buffers_.amount_out));
+  ESP_LOGVV(TAG, "TX: %s", format_hex_pretty(this->buffers_.tx, this->buffers_.amount_out).c_str());
 }
 
 void EnergomeraIecComponent::prepare_frame_(const uint8_t *data, size_t length) {
   memcpy(this->buffers_.out, data, length);
+  this->buffers_.tx = this->buffers_.out;
   this->buffers_.amount_out = length;
 }
 
+// Sends without copying, data has to stay valid for retries
 void EnergomeraIecComponent::send_frame_(const uint8_t *data, size_t length) {
-  this->prepare_frame_(data, length);
+  this->buffers_.tx = data;
+  this->buffers_.amount_out = length;
   this->send_frame_prepared_();
 }
 
-size_t EnergomeraIecComponent::receive_frame_(FrameStopFunction stop_fn) {
+size_t EnergomeraIecComponent::read_frame_(Reader reader) {
+  switch (reader) {
+    case Reader::ASCII:
+      return this->receive_frame_ascii_();
+    case Reader::ACK_NACK:
+      return this->receive_frame_ack_nack_();
+    case Reader::PROG_SOH:
+      return this->receive_prog_frame_(SOH);
+    case Reader::PROG_STX:
+      return this->receive_prog_frame_(STX);
+    default:
+      return 0;
+  }
+}
+
+// Template, so the stop check lambdas are inlined instead of wrapped into std::function on every call
+template<typename StopFn> size_t EnergomeraIecComponent::receive_frame_(StopFn &&stop_fn) {
   const uint32_t read_time_limit_ms = 25;
   size_t ret_val;
 
-  auto count = this->available();
+  auto count = this->transport_->available();
   if (count <= 0)
     return 0;
 
@@ -885,20 +2325,25 @@ size_t EnergomeraIecComponent::receive_frame_(FrameStopFunction stop_fn) {
 
     if (this->buffers_.amount_in < MAX_IN_BUF_SIZE) {
       p = &this->buffers_.in[this->buffers_.amount_in];
-      if (!iuart_->read_one_byte(p)) {
+      if (!this->transport_->read_one_byte(p)) {
         return 0;
       }
       this->buffers_.amount_in++;
     } else {
       memmove(this->buffers_.in, this->buffers_.in + 1, this->buffers_.amount_in - 1);
       p = &this->buffers_.in[this->buffers_.amount_in - 1];
-      if (!iuart_->read_one_byte(p)) {
+      if (!this->transport_->read_one_byte(p)) {
         return 0;
       }
     }
+    // parsers work on C strings, bytes of a previous longer frame must not show up past this one
+    this->buffers_.in[this->buffers_.amount_in] = '\0';
+    // timeout is for silence on the line, a long frame at a low baud rate takes longer than that to arrive
+    this->update_last_rx_time_();
 
     if (stop_fn(this->buffers_.in, this->buffers_.amount_in)) {
-      ESP_LOGV(TAG, "RX: %s", format_frame_pretty(this->buffers_.in, this->buffers_.amount_in).c_str());
+      this->trace_frame_(FrameTrace::Direction::RX, this->buffers_.in, this->buffers_.amount_in);
+      ESP_LOGV(TAG, "RX: %s", format_frame_pretty(this->buffers_.in, this->buffers_.amount_in));
       ESP_LOGVV(TAG, "RX: %s", format_hex_pretty(this->buffers_.in, this->buffers_.amount_in).c_str());
       ret_val = this->buffers_.amount_in;
       this->buffers_.amount_in = 0;
@@ -964,44 +2409,88 @@ size_t EnergomeraIecComponent::receive_prog_frame_(uint8_t start_byte, bool acce
 }
 
 void EnergomeraIecComponent::clear_rx_buffers_() {
-  int available = this->available();
+  int available = this->transport_->available();
   if (available > 0) {
-    ESP_LOGVV(TAG, "Cleaning garbage from UART input buffer: %d bytes", available);
+    ESP_LOGVV(TAG, "Cleaning garbage from input buffer: %d bytes", available);
   }
 
-  int len;
-  while (available > 0) {
-    len = std::min(available, (int) MAX_IN_BUF_SIZE);
-    this->read_array(this->buffers_.in, len);
-    available -= len;
+  uint8_t garbage;
+  while (available-- > 0 && this->transport_->read_one_byte(&garbage)) {
   }
-  memset(this->buffers_.in, 0, MAX_IN_BUF_SIZE);
+  memset(this->buffers_.in, 0, sizeof(this->buffers_.in));
   this->buffers_.amount_in = 0;
 }
 
 char *EnergomeraIecComponent::extract_meter_id_(size_t frame_size) {
-  uint8_t *p = &this->buffers_.in[frame_size - 1 - 2 /*\r\n*/];
-  size_t min_id_data_size = 7;  // min packet is '/XXXZ\r\n'
-
-  while (p >= this->buffers_.in && frame_size >= min_id_data_size) {
-    if ('/' == *p) {
-      if ((size_t) (&this->buffers_.in[MAX_IN_BUF_SIZE - 1] - p) < min_id_data_size) {
-        ESP_LOGV(TAG, "Invalid Meter ID packet.");
-        // garbage, ignore
-        break;
-      }
-      this->buffers_.in[frame_size - 2] = '\0';  // terminate string and remove \r\n
-      ESP_LOGD(TAG, "Meter identification: '%s'", p);
-
-      return (char *) p;
+  const size_t min_id_data_size = 7;  // min packet is '/XXXZ\r\n'
+  if (frame_size < min_id_data_size || frame_size > MAX_IN_BUF_SIZE)
+    return nullptr;
+  // the last '/' starts the identification, whatever is before it is line noise
+  size_t end = frame_size - 2;  // \r\n
+  for (size_t i = end; i-- > 0;) {
+    if (this->buffers_.in[i] != '/')
+      continue;
+    if (end - i < min_id_data_size - 2) {
+      ESP_LOGV(TAG, "Invalid Meter ID packet.");
+      // garbage, ignore
+      return nullptr;
     }
-
-    p--;
+    this->buffers_.in[end] = '\0';  // terminate string and remove \r\n
+    ESP_LOGD(TAG, "Meter identification: '%s'", &this->buffers_.in[i]);
+    return (char *) &this->buffers_.in[i];
   }
-
   return nullptr;
 }
 
+// Reply is "DATE_(...)" without the leading STX, date goes to meter_datetime_str_ as "20yy-mm-dd ".
+// Weekday has one digit on single-phase meters, two on the others. Both are taken whatever the profile says,
+// firmware versions differ.
+//       0         1         2         3
+//       01234567890123456789012345678901234567890
+//  <STX>DATE_(5.30.05.25)<CR><LF><ETX><BCC> (22)     // ce102m, ce207
+//  <STX>DATE_(05.30.05.25)<CR><LF><ETX><BCC> (23)    // ce301, etc.
+bool EnergomeraIecComponent::parse_meter_date_(const char *reply, size_t frame_size) {
+  const size_t framing = 12;  // <STX>DATE_( and )<CR><LF><ETX><BCC>
+  const size_t min_date_len = 10;
+  const MeterProfile *profile = this->meter_ != nullptr ? this->meter_->profile : nullptr;
+  if (frame_size < framing + min_date_len || strncmp(reply, "DATE_(", 6) != 0)
+    return false;
+  size_t date_len = frame_size - framing;
+  if (date_len > min_date_len + 1)
+    return false;
+  if (profile != nullptr && date_len != profile->date_len)
+    ESP_LOGV(TAG, "Meter date '%.*s' is not in the %s format", (int) date_len, reply + 6, profile->model);
+  const char *end = reply + 6 + date_len;  // "dd.mm.yy)" ends here
+  if (*end != ')')
+    return false;
+  // assume it is year 20xx.
+  this->meter_datetime_str_[0] = '2';
+  this->meter_datetime_str_[1] = '0';
+  this->meter_datetime_str_[2] = end[-2];  // year
+  this->meter_datetime_str_[3] = end[-1];  // year
+  this->meter_datetime_str_[4] = '-';      // separator
+  this->meter_datetime_str_[5] = end[-5];  // month
+  this->meter_datetime_str_[6] = end[-4];  // month
+  this->meter_datetime_str_[7] = '-';      // separator
+  this->meter_datetime_str_[8] = end[-8];  // day
+  this->meter_datetime_str_[9] = end[-7];  // day
+  this->meter_datetime_str_[10] = ' ';     // separator
+  this->meter_datetime_str_[11] = '\0';
+  return true;
+}
+
+// Reply is "TIME_(HH:MM:SS)" without the leading STX, time is appended to the date in meter_datetime_str_.
+//      0         1         2         3
+//      01234567890123456789012345678901234567890
+// <STX>TIME_(23:40:10)<CR><LF><ETX><17> (20)
+bool EnergomeraIecComponent::parse_meter_time_(const char *reply, size_t frame_size) {
+  if (frame_size != 20 || strncmp(reply, "TIME_(", 6) != 0)
+    return false;
+  memcpy(this->meter_datetime_str_ + 11, reply + 6, 8);  // copy HH:MM:SS
+  this->meter_datetime_str_[19] = '\0';                  // null-terminate the string
+  return true;
+}
+
 uint8_t EnergomeraIecComponent::get_values_from_brackets_(char *line, ValueRefsArray &vals) {
   // line = "VOLTA(100.1)VOLTA(200.1)VOLTA(300.1)VOLTA(400.1)"
   vals.fill(empty_str);
@@ -1088,6 +2577,10 @@ const char *EnergomeraIecComponent::state_to_string(State state) {
       return "PUBLISH";
     case State::SINGLE_READ_ACK:
       return "SINGLE_READ_ACK";
+    case State::READOUT:
+      return "READOUT";
+    case State::BRIDGE:
+      return "BRIDGE";
     default:
       return "UNKNOWN";
   }
@@ -1106,33 +2599,121 @@ void EnergomeraIecComponent::log_state_(State *next_state) {
 
 void EnergomeraIecComponent::stats_dump_() {
   ESP_LOGV(TAG, "============================================");
-  ESP_LOGV(TAG, "Data collection and publishing finished.");
-  ESP_LOGV(TAG, "Total number of sessions ............. %u", this->stats_.connections_tried_);
-  ESP_LOGV(TAG, "Total number of invalid frames ....... %u", this->stats_.invalid_frames_);
-  ESP_LOGV(TAG, "Total number of CRC errors ........... %u", this->stats_.crc_errors_);
-  ESP_LOGV(TAG, "Total number of CRC errors recovered . %u", this->stats_.crc_errors_recovered_);
-  ESP_LOGV(TAG, "CRC errors per session ............... %f", this->stats_.crc_errors_per_session());
-  ESP_LOGV(TAG, "Number of failures ................... %u", this->stats_.failures_);
+  ESP_LOGV(TAG, "Data collection and publishing finished for meter '%s'.", this->meter_->address);
+  ESP_LOGV(TAG, "Total number of sessions ............. %u", this->meter_->stats.connections_tried_);
+  ESP_LOGV(TAG, "Total number of invalid frames ....... %u", this->meter_->stats.invalid_frames_);
+  ESP_LOGV(TAG, "Total number of CRC errors ........... %u", this->meter_->stats.crc_errors_);
+  ESP_LOGV(TAG, "Total number of CRC errors recovered . %u", this->meter_->stats.crc_errors_recovered_);
+  ESP_LOGV(TAG, "CRC errors per session ............... %f", this->meter_->stats.crc_errors_per_session());
+  ESP_LOGV(TAG, "Number of failures ................... %u", this->meter_->stats.failures_);
+  for (size_t i = (size_t) Recovery::RESET_LINK; i < (size_t) Recovery::REBOOT; i++) {
+    if (this->recovery_.entered[i] == 0)
+      continue;
+    ESP_LOGV(TAG, "Recovery %-15s ............ entered %u, fixed %u, %u ms", this->recovery_to_string_((Recovery) i),
+             this->recovery_.entered[i], this->recovery_.fixed[i], this->recovery_.time_ms[i]);
+  }
+  ESP_LOGV(TAG, "Loop calls while idle ................ %u", this->loop_stats_.idle_calls);
+  ESP_LOGV(TAG, "Loop calls while active .............. %u", this->loop_stats_.active_calls);
+  if (this->loop_stats_.active_calls > 0) {
+    uint32_t active_ms = this->loop_stats_.active_ms + (millis() - this->loop_stats_.woken_ms);
+    float period_ms = (float) active_ms / this->loop_stats_.active_calls;
+    ESP_LOGV(TAG, "Average loop period while active ..... %.2f ms", period_ms);
+    ESP_LOGV(TAG, "States run without a loop() call ..... %u, max %u at once", this->loop_stats_.hops,
+             this->loop_stats_.max_hops);
+    // each of them would otherwise have waited for the next loop() call
+    ESP_LOGV(TAG, "Time saved on that, estimated ........ %.0f ms", period_ms * this->loop_stats_.hops);
+  }
+  ESP_LOGV(TAG, "Sessions per hour .................... %.1f", this->get_sessions_per_hour());
+  ESP_LOGV(TAG, "Bus time per answered request ........ %.1f ms", this->get_ms_per_request());
+  ESP_LOGV(TAG, "Bus idle ............................. %.1f%%", this->get_bus_idle_fraction() * 100.0f);
+  if (this->lock_wait_.waits > 0) {
+    ESP_LOGV(TAG, "Waits for the bus .................... %u, avg %u ms, max %u ms, %u longer than interval",
+             this->lock_wait_.waits, this->lock_wait_.total_ms / this->lock_wait_.waits, this->lock_wait_.max_ms,
+             this->lock_wait_.starved);
+  }
+#ifdef USE_ENERGOMERA_IEC_SOCKET
+  if (this->bridge_ != nullptr) {
+    uint32_t bridge_ms = millis() - this->bridge_->get_started_ms();
+    for (const auto &client : this->bridge_->get_stats()) {
+      ESP_LOGV(TAG, "Bridge client %-15s ........ %u slots, %u ms, %.1f%% of bus time", client.peer, client.slots,
+               client.bus_ms, bridge_ms > 0 ? client.bus_ms * 100.0f / bridge_ms : 0.0f);
+    }
+  }
+#endif
+  if (this->reading_buffer_.enabled()) {
+    ESP_LOGV(TAG, "Buffered readings .................... %u", (unsigned) this->reading_buffer_.size());
+    ESP_LOGV(TAG, "Buffered readings overwritten ........ %u", this->reading_buffer_.get_overwritten());
+    ESP_LOGV(TAG, "Buffered readings expired ............ %u", this->readings_expired_);
+  }
+  auto &sensors = this->meter_->sensors;
+  for (auto it = sensors.begin(); it != sensors.end(); it = sensors.upper_bound(it->first)) {
+    uint32_t age = this->get_request_value_age_ms(it->first);
+    if (age == UINT32_MAX) {
+      ESP_LOGV(TAG, "Value age %-15s ........... never read", it->first.c_str());
+    } else {
+      ESP_LOGV(TAG, "Value age %-15s ........... %u ms", it->first.c_str(), age);
+    }
+  }
   ESP_LOGV(TAG, "============================================");
 }
 
+static const char *trace_check_to_string(FrameTrace::Check check) {
+  switch (check) {
+    case FrameTrace::Check::BCC_OK:
+      return "BCC ok";
+    case FrameTrace::Check::BCC_FAILED:
+      return "BCC failed";
+    case FrameTrace::Check::INCOMPLETE:
+      return "incomplete";
+    default:
+      return "";
+  }
+}
+
+void EnergomeraIecComponent::dump_trace() {
+  if (this->trace_.capacity() == 0) {
+    ESP_LOGW(TAG, "Frame trace is off, set trace_size to use it");
+    return;
+  }
+  uint32_t now = millis();
+  ESP_LOGI(TAG, "Frame trace: last %u frames, oldest first", (unsigned) this->trace_.size());
+  for (size_t i = 0; i < this->trace_.size(); i++) {
+    const auto &entry = this->trace_.get(i);
+    ESP_LOGI(TAG, "%7u ms ago %s %-22s %-10s %s%s", now - entry.ms,
+             entry.direction == FrameTrace::Direction::TX ? "TX" : "RX", this->state_to_string((State) entry.state),
+             trace_check_to_string(entry.check), format_frame_pretty(entry.data, entry.stored),
+             entry.size > entry.stored ? str_sprintf(" cut, %u bytes", entry.size).c_str() : "");
+  }
+}
+
 bool EnergomeraIecComponent::try_lock_uart_session_() {
-  if (AnyObjectLocker::try_lock(this->parent_)) {
-    ESP_LOGVV(TAG, "UART bus %p locked by %s", this->parent_, this->tag_.c_str());
+  void *bus = this->bus_id_();
+  if (AnyObjectLocker::try_lock(bus)) {
+    ESP_LOGVV(TAG, "Bus %p locked by %s", bus, this->tag_);
+    this->throughput_.locked_ms = millis();
+    this->throughput_.locked = true;
     return true;
   }
-  ESP_LOGVV(TAG, "UART bus %p busy", this->parent_);
+  ESP_LOGVV(TAG, "Bus %p busy", bus);
   return false;
 }
 
 void EnergomeraIecComponent::unlock_uart_session_() {
-  AnyObjectLocker::unlock(this->parent_);
-  ESP_LOGVV(TAG, "UART bus %p released by %s", this->parent_, this->tag_.c_str());
+  void *bus = this->bus_id_();
+  AnyObjectLocker::unlock(bus);
+  ESP_LOGVV(TAG, "Bus %p released by %s", bus, this->tag_);
+  if (this->throughput_.locked) {
+    this->throughput_.bus_ms += millis() - this->throughput_.locked_ms;
+    this->throughput_.locked = false;
+  }
 }
 
 uint8_t EnergomeraIecComponent::next_obj_id_ = 0;
+std::vector<EnergomeraIecComponent *> EnergomeraIecComponent::instances_;
 
-std::string EnergomeraIecComponent::generateTag() { return str_sprintf("%s%03d", TAG0, ++next_obj_id_); }
+void EnergomeraIecComponent::generateTag(char *tag, size_t size) {
+  snprintf(tag, size, "%s%03d", TAG0, ++next_obj_id_);
+}
 
 }  // namespace energomera_iec
 }  // namespace esphome
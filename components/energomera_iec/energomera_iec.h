@@ -1,6 +1,8 @@
 #pragma once
 
+#include "esphome/core/defines.h"
 #include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
 #include "esphome/components/uart/uart.h"
 #include "esphome/components/sensor/sensor.h"
 #include "esphome/components/binary_sensor/binary_sensor.h"
@@ -9,14 +11,32 @@
 #include "esphome/components/time/real_time_clock.h"
 #endif
 
+#ifdef USE_API
+#include "esphome/components/api/api_server.h"
+#endif
+
+#ifdef USE_MQTT
+#include "esphome/components/mqtt/mqtt_client.h"
+#endif
+
+#include <algorithm>
 #include <cstdint>
 #include <string>
 #include <memory>
 #include <map>
 #include <list>
+#include <vector>
 
+#include "energomera_iec_transport.h"
 #include "energomera_iec_uart.h"
 #include "energomera_iec_sensor.h"
+#include "energomera_iec_buffer.h"
+#include "energomera_iec_trace.h"
+#include "energomera_iec_profiles.h"
+#ifdef USE_ENERGOMERA_IEC_SOCKET
+#include "energomera_iec_tcp.h"
+#include "energomera_iec_bridge.h"
+#endif
 #include "object_locker.h"
 
 namespace esphome {
@@ -24,6 +44,7 @@ namespace energomera_iec {
 
 static const size_t MAX_IN_BUF_SIZE = 256;
 static const size_t MAX_OUT_BUF_SIZE = 84;
+static const size_t READOUT_STAGE_SIZE = 512;
 
 const uint8_t VAL_NUM = 12;
 using ValueRefsArray = std::array<char *, VAL_NUM>;
@@ -31,12 +52,18 @@ using ValueRefsArray = std::array<char *, VAL_NUM>;
 using SensorMap = std::multimap<std::string, EnergomeraIecSensorBase *>;
 using SingleRequests = std::list<std::string>;
 
-using FrameStopFunction = std::function<bool(uint8_t *buf, size_t size)>;
-using ReadFunction = std::function<size_t()>;
-
 class EnergomeraIecComponent : public PollingComponent, public uart::UARTDevice {
  public:
-  EnergomeraIecComponent() : tag_(generateTag()){};
+  EnergomeraIecComponent() {
+    generateTag(this->tag_, sizeof(this->tag_));
+    instances_.push_back(this);
+  };
+  // lives as long as the firmware on the device, host tests build and drop instances
+  ~EnergomeraIecComponent() {
+    if (this->throughput_.locked)
+      AnyObjectLocker::unlock(this->bus_id_());
+    instances_.erase(std::remove(instances_.begin(), instances_.end(), this), instances_.end());
+  }
 
   void setup() override;
   void dump_config() override;
@@ -44,45 +71,139 @@ class EnergomeraIecComponent : public PollingComponent, public uart::UARTDevice
   void update() override;
   float get_setup_priority() const override { return setup_priority::DATA; };
 
-  void set_meter_address(const std::string &addr) { this->meter_address_ = addr; };
-  void set_baud_rates(uint32_t baud_rate_handshake, uint32_t baud_rate) {
-    this->baud_rate_handshake_ = baud_rate_handshake;
+  void add_meter(const char *address);
+  // settings given here win over the meter model profile
+  void set_baud_rate_handshake(uint32_t baud_rate) { this->baud_rate_handshake_ = baud_rate; };
+  void set_baud_rate(uint32_t baud_rate) {
     this->baud_rate_ = baud_rate;
+    this->configured_.baud_rate = true;
+  };
+  void set_receive_timeout_ms(uint32_t timeout) {
+    this->receive_timeout_ms_ = timeout;
+    this->configured_.receive_timeout = true;
+  };
+  void set_delay_between_requests_ms(uint32_t delay) {
+    this->delay_between_requests_ms_ = delay;
+    this->configured_.delay_between_requests = true;
   };
-  void set_receive_timeout_ms(uint32_t timeout) { this->receive_timeout_ms_ = timeout; };
-  void set_delay_between_requests_ms(uint32_t delay) { this->delay_between_requests_ms_ = delay; };
+  // "AUTO" - by identification, "NONE" - no profile, or model name
+  void set_model(const std::string &model) { this->model_ = model; };
+  void set_session_budget_ms(uint32_t budget) { this->session_budget_ms_ = budget; };
   void set_flow_control_pin(GPIOPin *flow_control_pin) { this->flow_control_pin_ = flow_control_pin; };
+#ifdef USE_ENERGOMERA_IEC_SOCKET
+  void set_tcp_transport(const std::string &host, uint16_t port, uint32_t latency_ms) {
+    this->transport_ = make_unique<EnergomeraIecTcpTransport>(host, port, latency_ms);
+  };
+#endif
+  void set_stagger(bool stagger) { this->stagger_ = stagger; };
+  void set_buffer_size(uint16_t size) { this->buffer_size_ = size; };
+  void set_restore_value(bool restore) { this->restore_value_ = restore; };
+  void set_restored_sensor(binary_sensor::BinarySensor *sensor) { this->restored_sensor_ = sensor; };
+  void set_boot_wait_ms(uint32_t boot_wait_ms) { this->boot_wait_ms_ = boot_wait_ms; };
+  void set_readout(bool readout) { this->readout_ = readout; };
+  void set_trace_size(uint16_t size) { this->trace_size_ = size; };
+#ifdef USE_ENERGOMERA_IEC_SOCKET
+  void set_bridge(uint16_t port, uint32_t idle_timeout_ms, uint32_t max_slot_ms) {
+    this->bridge_ = make_unique<EnergomeraIecBridge>(port);
+    this->bridge_idle_timeout_ms_ = idle_timeout_ms;
+    this->bridge_max_slot_ms_ = max_slot_ms;
+  };
+#endif
 
   void register_sensor(EnergomeraIecSensorBase *sensor);
+  void register_sensor(EnergomeraIecSensorBase *sensor, const char *meter_address);
   void set_reboot_after_failure(uint16_t number_of_failures) { this->failures_before_reboot_ = number_of_failures; }
 
   void queue_single_read(const std::string &req);
 
+  // Poll only given requests every interval_ms for duration_ms, then return to normal cycle
+  void start_burst(const std::vector<std::string> &requests, uint32_t duration_ms, uint32_t interval_ms = 1000);
+  void stop_burst();
+  bool is_burst_active() const { return this->burst_.active; }
+  float get_burst_refresh_rate() const;     // cycles per second since burst start
+  float get_burst_bus_utilization() const;  // share of burst time the bus was busy, 0..1
+
+  // Since boot, to compare settings and firmware builds on the real bus
+  float get_sessions_per_hour() const;  // completed meter sessions
+  float get_ms_per_request() const;     // bus time held per answered request
+  float get_bus_idle_fraction();        // no component on this bus held it, 0..1
+  void dump_throughput();               // one JSON line
+
+  // Frames on the wire are recorded while enabled, trace_size sets how many are kept
+  void set_trace_enabled(bool enabled) { this->trace_.set_enabled(enabled); }
+  bool is_trace_enabled() const { return this->trace_.enabled(); }
+  void dump_trace();
+  void clear_trace() { this->trace_.clear(); }
+
+  // ms since the freshest value of the request was received from any meter, UINT32_MAX if never
+  uint32_t get_request_value_age_ms(const std::string &req);
+
 #ifdef USE_TIME
   void set_time_source(time::RealTimeClock *rtc) { this->time_source_ = rtc; };
+  void set_align_to_clock(bool align) { this->align_to_clock_ = align; };
+  void set_auto_time_sync(bool auto_sync) { this->auto_time_sync_ = auto_sync; };
   void sync_device_time();  // set current time from RTC
 #endif
   void set_device_time(uint32_t timestamp);  // set time from given timestamp
 
  protected:
-  std::string meter_address_{""};
   uint32_t receive_timeout_ms_{500};
   uint32_t delay_between_requests_ms_{50};
+  uint32_t session_budget_ms_{0};  // 0 = derived from update interval
+
+  std::string model_{"AUTO"};
+  struct {
+    bool baud_rate{false};
+    bool receive_timeout{false};
+    bool delay_between_requests{false};
+  } configured_;
+  void select_profile_();
+  void apply_profile_();
 
   GPIOPin *flow_control_pin_{nullptr};
-  std::unique_ptr<EnergomeraIecUart> iuart_;
+  std::unique_ptr<EnergomeraIecTransport> transport_;
+  uint32_t timeout_margin_ms_{0};
+  void *bus_id_() { return this->transport_ ? this->transport_->bus_id() : this->parent_; }
 
 #ifdef USE_TIME
   time::RealTimeClock *time_source_{nullptr};
+  bool align_to_clock_{false};
+  bool auto_time_sync_{false};
+  uint32_t last_aligned_boundary_{0};  // timestamp of the last scheduled aligned poll
+  bool schedule_aligned_poll_();
 #endif
+  bool stagger_{true};
+
+  // Staggered and aligned polls wait for their moment in loop(), not in a scheduler item made each cycle
+  struct {
+    uint32_t at_ms{0};
+    bool pending{false};
+    bool aligned{false};  // next one is scheduled to the clock when this one starts
+  } poll_deadline_;
+  void schedule_poll_(uint32_t delay_ms);
+  void check_poll_deadline_();
+
+  void start_poll_();
+  uint32_t stagger_offset_ms_();
+  uint32_t read_timestamp_();
 
-  SensorMap sensors_;
   SingleRequests single_requests_;
 
   sensor::Sensor *crc_errors_per_session_sensor_{};
 
   uint32_t time_to_set_{0};
   uint32_t time_to_set_requested_at_ms_{0};
+  uint32_t time_request_ms_{0};  // TIME_() sent
+  int32_t correction_sent_s_{0};
+
+  bool time_sync_due_();
+  char meter_datetime_str_[20]{};  // "2025-05-30 23:40:10" from DATE_() and TIME_()
+  bool parse_meter_date_(const char *reply, size_t frame_size);
+  bool parse_meter_time_(const char *reply, size_t frame_size);
+  void update_clock_model_(float offset_s, double true_ts);
+  int32_t plan_clock_correction_(float offset_s, uint32_t meter_day);
+  void clock_corrected_(int32_t correction_s);
+  void save_clock_model_();
 
   enum class State : uint8_t {
     NOT_INITIALIZED,
@@ -105,6 +226,8 @@ class EnergomeraIecComponent : public PollingComponent, public uart::UARTDevice
     PUBLISH,
     SINGLE_READ,
     SINGLE_READ_ACK,
+    READOUT,
+    BRIDGE,
   } state_{State::NOT_INITIALIZED};
   State last_reported_state_{State::NOT_INITIALIZED};
 
@@ -114,15 +237,51 @@ class EnergomeraIecComponent : public PollingComponent, public uart::UARTDevice
     State next_state{State::IDLE};
   } wait_;
 
+  // loop() is off while idle and runs at high frequency during sessions
+  HighFrequencyLoopRequester high_freq_;
+  struct {
+    uint32_t idle_calls{0};    // loop() calls that found nothing to do
+    uint32_t active_calls{0};  // loop() calls while working
+    uint32_t active_ms{0};     // time spent with loop enabled
+    uint32_t woken_ms{0};
+    uint32_t hops{0};     // states run right after the previous one, in the same loop() call
+    uint8_t max_hops{0};  // most of them in one loop() call
+  } loop_stats_;
+  struct {
+    uint32_t started_ms{0};
+    uint32_t sessions{0};
+    uint32_t requests{0};  // readout datasets that went to sensors count as well
+    uint32_t bus_ms{0};    // bridge slots included
+    uint32_t locked_ms{0};
+    bool locked{false};
+  } throughput_;
+  uint32_t bus_held_ms_() const;
+  void wake_();
+  void sleep_();
+  void run_state_();
+  static bool is_waiting_state_(State state);
+
   bool is_idling() const { return this->state_ == State::WAIT || this->state_ == State::IDLE; };
 
-  void set_next_state_(State next_state) { state_ = next_state; };
+  void set_next_state_(State next_state) {
+    if (this->state_ == State::IDLE && next_state != State::IDLE)
+      this->wake_();
+    this->state_ = next_state;
+  };
   void set_next_state_delayed_(uint32_t ms, State next_state);
 
-  void read_reply_and_go_next_state_(ReadFunction read_fn, State next_state, uint8_t retries, bool mission_critical,
+  // which kind of frame WAITING_FOR_RESPONSE waits for
+  enum class Reader : uint8_t {
+    ASCII,     // "data<CR><LF>"
+    ACK_NACK,  // "<ACK>" or "<NAK>"
+    PROG_SOH,  // "<SOH>data<ETX><BCC>"
+    PROG_STX,  // "<STX>data<ETX><BCC>"
+  };
+
+  void read_reply_and_go_next_state_(Reader reader, State next_state, uint8_t retries, bool mission_critical,
                                      bool check_crc);
   struct {
-    ReadFunction read_fn;
+    Reader reader;
     State next_state;
     bool mission_critical;
     bool check_crc;
@@ -130,7 +289,7 @@ class EnergomeraIecComponent : public PollingComponent, public uart::UARTDevice
     uint8_t tries_counter;
     uint32_t err_crc;
     uint32_t err_invalid_frames;
-  } reading_state_{nullptr, State::IDLE, false, false, 0, 0, 0, 0};
+  } reading_state_{Reader::ASCII, State::IDLE, false, false, 0, 0, 0, 0};
   size_t received_frame_size_{0};
 
   uint32_t baud_rate_handshake_{9600};
@@ -139,20 +298,26 @@ class EnergomeraIecComponent : public PollingComponent, public uart::UARTDevice
   uint32_t last_rx_time_{0};
 
   struct {
-    uint8_t in[MAX_IN_BUF_SIZE];
+    uint8_t in[MAX_IN_BUF_SIZE + 1];  // always null-terminated
     size_t amount_in;
     uint8_t out[MAX_OUT_BUF_SIZE];
+    const uint8_t *tx;  // frame being sent, either out or a constant frame
     size_t amount_out;
   } buffers_;
 
   void clear_rx_buffers_();
 
   void set_baud_rate_(uint32_t baud_rate);
-  bool are_baud_rates_different_() const { return baud_rate_handshake_ != baud_rate_; }
+  bool are_baud_rates_different_() const {
+    return baud_rate_handshake_ != baud_rate_ && this->transport_->supports_baud_rate_change();
+  }
 
   uint8_t calculate_crc_prog_frame_(uint8_t *data, size_t length, bool set_crc = false);
   bool check_crc_prog_frame_(uint8_t *data, size_t length);
 
+  std::vector<uint8_t> frame_table_;  // R1 frames of all configured requests
+  void build_frame_table_();
+
   void prepare_frame_(const uint8_t *data, size_t length);
   void prepare_prog_frame_(const char *request, bool write = false);
   void prepare_non_session_prog_frame_(const char *request);
@@ -161,23 +326,41 @@ class EnergomeraIecComponent : public PollingComponent, public uart::UARTDevice
   void send_frame_(const uint8_t *data, size_t length);
   void send_frame_prepared_();
 
-  size_t receive_frame_(FrameStopFunction stop_fn);
+  size_t read_frame_(Reader reader);
+  template<typename StopFn> size_t receive_frame_(StopFn &&stop_fn);
   size_t receive_frame_ascii_();
   size_t receive_frame_ack_nack_();
   size_t receive_prog_frame_(uint8_t start_byte, bool accept_ack_and_nack = false);
 
   inline void update_last_rx_time_() { this->last_rx_time_ = millis(); }
   bool check_wait_timeout_() { return millis() - wait_.start_time >= wait_.delay_ms; }
-  bool check_rx_timeout_() { return millis() - this->last_rx_time_ >= receive_timeout_ms_; }
+  bool check_rx_timeout_() { return millis() - this->last_rx_time_ >= receive_timeout_ms_ + timeout_margin_ms_; }
 
   char *extract_meter_id_(size_t frame_size);
   uint8_t get_values_from_brackets_(char *line, ValueRefsArray &vals);
   char *get_nth_value_from_csv_(char *line, uint8_t idx);
-  bool set_sensor_value_(EnergomeraIecSensorBase *sensor, ValueRefsArray &vals);
+  bool set_sensor_value_(EnergomeraIecSensorBase *sensor, const char *req, ValueRefsArray &vals, uint32_t read_ms,
+                         uint32_t timestamp);
 
   void report_failure(bool failure);
   void abort_mission_();
 
+  // Steps tried one by one while all meters keep failing, reboot is the last one
+  enum class Recovery : uint8_t { NONE, RESET_LINK, TOGGLE_FLOW_PIN, BACK_OFF, REBOOT, COUNT };
+  struct {
+    Recovery level{Recovery::NONE};
+    uint32_t level_started_ms{0};
+    uint8_t failures{0};        // bus-wide failures seen by the ladder
+    uint8_t backoff_factor{1};  // poll every n-th time
+    uint8_t polls_to_skip{0};
+    uint32_t entered[(size_t) Recovery::COUNT]{};
+    uint32_t fixed[(size_t) Recovery::COUNT]{};  // success came while at this level
+    uint32_t time_ms[(size_t) Recovery::COUNT]{};
+  } recovery_;
+  void escalate_recovery_();
+  void set_recovery_level_(Recovery level);
+  const char *recovery_to_string_(Recovery level);
+
   const char *state_to_string(State state);
   void log_state_(State *next_state = nullptr);
 
@@ -189,28 +372,170 @@ class EnergomeraIecComponent : public PollingComponent, public uart::UARTDevice
     uint8_t failures_{0};
 
     float crc_errors_per_session() const { return (float) crc_errors_ / connections_tried_; }
-  } stats_;
+  };
   void stats_dump_();
 
+  bool restore_value_{false};
+  void restore_values_();
+  // on while any value published is still the one from before the reboot
+  binary_sensor::BinarySensor *restored_sensor_{nullptr};
+  void publish_restored_();
+  void clear_values_();
+
+  uint32_t boot_wait_ms_{10000};  // upper limit, boot ends as soon as the bus is quiet
+  uint32_t boot_started_ms_{0};
+  uint32_t boot_last_rx_ms_{0};
+  void check_boot_done_();
+
+#ifdef USE_ENERGOMERA_IEC_SOCKET
+  // External client gets the bus between our sessions
+  std::unique_ptr<EnergomeraIecBridge> bridge_;
+  uint32_t bridge_idle_timeout_ms_{0};
+  uint32_t bridge_max_slot_ms_{0};
+  uint32_t bridge_slot_started_ms_{0};
+  bool bridge_poll_pending_{false};  // poll came while the client had the bus
+  void bridge_listen_();
+  void bridge_loop_();
+  bool is_bus_wanted_();  // a poll waits for the bus the client holds
+  void bridge_forward_();
+  void bridge_release_(const char *reason);
+#endif
+
+  uint16_t trace_size_{0};
+  FrameTrace trace_;
+  void trace_frame_(FrameTrace::Direction direction, const uint8_t *data, size_t size,
+                    FrameTrace::Check check = FrameTrace::Check::NONE) {
+    if (this->trace_.enabled())
+      this->trace_.record(direction, (uint8_t) this->state_, data, size, check);
+  }
+
+  uint16_t buffer_size_{0};
+  ReadingBuffer reading_buffer_;
+  uint32_t readings_expired_{0};
+
+  bool is_link_up_();
+  void publish_sensor_(EnergomeraIecSensorBase *sensor);
+  void drain_reading_buffer_();
+
+  // Data readout mode: the meter streams all its values in one block, programming mode reads only what is missing
+  bool readout_{false};
+  struct {
+    enum class Stage : uint8_t { WAIT_STX, DATA, BCC } stage;
+    uint8_t bcc;
+    bool line_start;    // next byte starts a new line
+    bool overflow;      // dataset does not fit into the input buffer
+    bool name_pending;  // line with a name being received, its dataset is not known yet
+    uint16_t line_offset;
+    uint16_t datasets;
+    uint16_t values;
+    uint32_t timestamp;
+    uint16_t staged_size;
+  } readout_state_{};
+  // datasets with sensors as "NAME(v1)(v2)\0...", applied only once the BCC of the whole block matches
+  char readout_staged_[READOUT_STAGE_SIZE]{};
+  bool use_readout_();
+  void start_readout_();
+  int8_t receive_readout_();
+  void process_readout_dataset_();
+  void split_readout_dataset_();
+  void apply_readout_();
+  void readout_finished_(bool ok);
+  uint8_t count_requests_not_read_out_();
+  bool is_request_read_out_(const std::string &req);
+
+  // Everything that differs between meters sharing this component, buffers and state machine are common
+  struct Meter {
+    char address[16]{};
+    char identity[32]{};  // "/EKT5CE102Mv01" as reported, kept across reboots
+    ESPPreferenceObject identity_pref;
+    const MeterProfile *profile{nullptr};
+    uint8_t open_cmd[24]{};  // "/?address!\r\n"
+    uint8_t open_cmd_size{0};
+    SensorMap sensors;
+    SensorMap::iterator resume_iter{nullptr};  // where next request cycle starts
+    Stats stats;
+    bool time_sync_pending{false};
+    uint8_t readout_failures{0};  // in a row, readout is not tried any more after a few
+    uint8_t readout_misses{0};    // requests the last good readout did not have, read out only if none
+    uint8_t readout_skipped{0};   // sessions without readout because of the misses
+    struct {
+      uint32_t checked_ts{0};   // last clock read, true time
+      float offset_s{0};        // meter minus true time, corrections applied since included
+      uint32_t baseline_ts{0};  // drift is measured from here
+      float baseline_offset_s{0};
+      float drift_s_per_day{0};
+      bool drift_known{false};
+      uint32_t budget_day{0};  // meter date as yyyymmdd
+      uint8_t corrected_s{0};  // correction used on that day
+    } clock;
+    ESPPreferenceObject clock_pref;
+  };
+  std::vector<Meter> meters_;
+  Meter *meter_{nullptr};  // meter in session
+  uint8_t meter_idx_{0};
+
+  Meter *find_or_add_meter_(const char *address);
+  void session_done_();
+
   uint8_t failures_before_reboot_{0};
 
   struct LoopState {
-    uint32_t session_started_ms{0};             // start of session
-    SensorMap::iterator request_iter{nullptr};  // talking to meter
-    SensorMap::iterator sensor_iter{nullptr};   // publishing sensor values
+    uint32_t session_started_ms{0};                   // start of session
+    uint32_t cycle_started_ms{0};                     // start of session with the first meter
+    bool session_open{false};                         // session kept open between burst cycles
+    SensorMap::iterator request_iter{nullptr};        // talking to meter
+    SensorMap::iterator first_request_iter{nullptr};  // where current request cycle started
+    bool wrapped{false};                              // request cycle went past the end of the map
+    SensorMap::iterator sensor_iter{nullptr};         // publishing sensor values
+    bool readout{false};                              // session opened in data readout mode
+    bool readout_fallback{false};                     // session reopened for what the readout missed
+    uint32_t readout_started_ms{0};
   } loop_state_;
 
+  struct {
+    bool active{false};
+    bool pending{false};  // requested during a regular session, starts when it is over
+    uint32_t started_ms{0};
+    uint32_t duration_ms{0};
+    uint32_t interval_ms{0};
+    uint32_t cycle_started_ms{0};  // start of current request cycle
+    uint32_t cycles{0};            // completed request cycles
+    uint32_t bus_busy_ms{0};       // time spent in request cycles
+    std::vector<std::string> requests;
+  } burst_;
+
+  bool is_request_selected_(const std::string &req) const;
+  SensorMap::iterator find_selected_request_(SensorMap::iterator from);
+  bool burst_expired_() const { return millis() - this->burst_.started_ms >= this->burst_.duration_ms; }
+  bool burst_keeps_session_open_() const;
+  void activate_burst_();
+  void burst_cycle_done_();
+
+  void start_request_cycle_();
+  void advance_request_();
+  bool session_budget_exceeded_();
+
   bool try_lock_uart_session_();
   void unlock_uart_session_();
+  bool is_waiting_for_bus_() const {
+    return this->state_ == State::WAIT && this->wait_.next_state == State::TRY_LOCK_BUS;
+  }
+  // Waits on a busy bus, a wait longer than update interval means a poll was lost to other instances
+  struct {
+    bool waiting{false};
+    uint32_t started_ms{0};
+    uint32_t waits{0};
+    uint32_t total_ms{0};
+    uint32_t max_ms{0};
+    uint32_t starved{0};
+  } lock_wait_;
 
  private:
   static uint8_t next_obj_id_;
-  std::string tag_;
-
-  static std::string generateTag();
+  static std::vector<EnergomeraIecComponent *> instances_;  // to stagger instances sharing a bus
+  char tag_[20]{};
 
-  // Data structures for time synchronization
-  char meter_datetime_str_[20]{};
+  static void generateTag(char *tag, size_t size);
 };
 
 }  // namespace energomera_iec
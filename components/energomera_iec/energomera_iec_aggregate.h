@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esphome/components/sensor/sensor.h"
+
+namespace esphome {
+namespace energomera_iec {
+
+// Running min/max/mean/last over a fixed window. Samples are only counted, results are published
+// once per window, when the first sample past the window boundary arrives.
+class EnergomeraIecAggregate {
+ public:
+  void set_window_ms(uint32_t window_ms) { window_ms_ = window_ms; }
+  void set_min_sensor(sensor::Sensor *sensor) { min_sensor_ = sensor; }
+  void set_max_sensor(sensor::Sensor *sensor) { max_sensor_ = sensor; }
+  void set_mean_sensor(sensor::Sensor *sensor) { mean_sensor_ = sensor; }
+  void set_last_sensor(sensor::Sensor *sensor) { last_sensor_ = sensor; }
+  void set_count_sensor(sensor::Sensor *sensor) { count_sensor_ = sensor; }
+
+  void add(double value, uint32_t read_ms) {
+    if (count_ > 0 && read_ms - window_start_ms_ >= window_ms_) {
+      publish_();
+      // next window starts at the boundary, not at the sample, so windows do not drift
+      window_start_ms_ = read_ms - (read_ms - window_start_ms_) % window_ms_;
+    } else if (count_ == 0) {
+      window_start_ms_ = read_ms;
+    }
+
+    if (count_ == 0 || value < min_)
+      min_ = value;
+    if (count_ == 0 || value > max_)
+      max_ = value;
+    sum_ += value;
+    last_ = value;
+    count_++;
+  }
+
+ protected:
+  uint32_t window_ms_{60000};
+  sensor::Sensor *min_sensor_{nullptr};
+  sensor::Sensor *max_sensor_{nullptr};
+  sensor::Sensor *mean_sensor_{nullptr};
+  sensor::Sensor *last_sensor_{nullptr};
+  sensor::Sensor *count_sensor_{nullptr};
+
+  uint32_t window_start_ms_{0};
+  uint32_t count_{0};
+  double min_{0};
+  double max_{0};
+  double sum_{0};
+  double last_{0};
+
+  void publish_() {
+    if (min_sensor_ != nullptr)
+      min_sensor_->publish_state(min_);
+    if (max_sensor_ != nullptr)
+      max_sensor_->publish_state(max_);
+    if (mean_sensor_ != nullptr)
+      mean_sensor_->publish_state(sum_ / count_);
+    if (last_sensor_ != nullptr)
+      last_sensor_->publish_state(last_);
+    if (count_sensor_ != nullptr)
+      count_sensor_->publish_state(count_);
+    count_ = 0;
+    sum_ = 0;
+  }
+};
+
+}  // namespace energomera_iec
+}  // namespace esphome
@@ -0,0 +1,153 @@
+#include "energomera_iec_bridge.h"
+
+#ifdef USE_ENERGOMERA_IEC_SOCKET
+
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace esphome {
+namespace energomera_iec {
+
+static const char *const TAG = "energomera_iec.bridge";
+
+static constexpr uint32_t LISTEN_RETRY_MS = 5000;
+
+void EnergomeraIecBridge::dump_config(const char *tag) {
+  ESP_LOGCONFIG(tag, "  Bridge: TCP port %u, %s", this->port_,
+                this->server_ != nullptr ? "listening" : "not listening");
+}
+
+void EnergomeraIecBridge::loop() {
+  if (this->server_ == nullptr) {
+    // network may come up later than we do
+    if (this->listen_tried_ms_ != 0 && millis() - this->listen_tried_ms_ < LISTEN_RETRY_MS)
+      return;
+    if (!this->listen_())
+      return;
+  }
+  this->accept_();
+  if (this->client_ != nullptr)
+    this->read_client_();
+}
+
+bool EnergomeraIecBridge::listen_() {
+  this->listen_tried_ms_ = millis();
+  this->server_ = socket::socket_ip(SOCK_STREAM, IPPROTO_TCP);
+  if (this->server_ == nullptr) {
+    ESP_LOGW(TAG, "Cannot create socket");
+    return false;
+  }
+  int enable = 1;
+  this->server_->setsockopt(SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int));
+  this->server_->setblocking(false);
+
+  struct sockaddr_storage addr;
+  socklen_t addr_len = socket::set_sockaddr_any((struct sockaddr *) &addr, sizeof(addr), this->port_);
+  if (this->server_->bind((struct sockaddr *) &addr, addr_len) != 0 || this->server_->listen(1) != 0) {
+    ESP_LOGW(TAG, "Cannot listen on port %u, errno %d", this->port_, errno);
+    this->server_->close();
+    this->server_ = nullptr;
+    return false;
+  }
+  ESP_LOGD(TAG, "Listening on port %u", this->port_);
+  this->started_ms_ = millis();
+  return true;
+}
+
+void EnergomeraIecBridge::accept_() {
+  struct sockaddr_storage addr;
+  socklen_t addr_len = sizeof(addr);
+  auto socket = this->server_->accept((struct sockaddr *) &addr, &addr_len);
+  if (socket == nullptr)
+    return;
+
+  std::string peer = socket->getpeername();
+  if (this->client_ != nullptr) {
+    ESP_LOGW(TAG, "Client %s turned away, %s is connected", peer.c_str(), this->current_->peer);
+    socket->close();
+    return;
+  }
+  socket->setblocking(false);
+  int enable = 1;
+  socket->setsockopt(IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(int));
+  this->client_ = std::move(socket);
+  this->current_ = this->find_stats_(peer.c_str());
+  this->pending_len_ = 0;
+  this->last_activity_ms_ = millis();
+  ESP_LOGI(TAG, "Client %s connected", this->current_->peer);
+}
+
+void EnergomeraIecBridge::read_client_() {
+  if (this->pending_len_ == sizeof(this->pending_))
+    return;  // bus has not taken the previous bytes yet
+  ssize_t read = this->client_->read(this->pending_ + this->pending_len_, sizeof(this->pending_) - this->pending_len_);
+  if (read > 0) {
+    this->pending_len_ += read;
+    this->current_->bytes_to_bus += read;
+    this->last_activity_ms_ = millis();
+  } else if (read == 0) {
+    ESP_LOGI(TAG, "Client %s disconnected", this->current_->peer);
+    this->drop_client_();
+  } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+    ESP_LOGW(TAG, "Read from %s failed, errno %d", this->current_->peer, errno);
+    this->drop_client_();
+  }
+}
+
+void EnergomeraIecBridge::send(const uint8_t *data, size_t len) {
+  if (this->client_ == nullptr)
+    return;
+  ssize_t written = this->client_->write(data, len);
+  if (written != (ssize_t) len) {
+    ESP_LOGW(TAG, "Write to %s failed (%d of %u bytes), errno %d", this->current_->peer, (int) written,
+             (unsigned) len, errno);
+    this->drop_client_();
+    return;
+  }
+  this->current_->bytes_from_bus += len;
+  this->last_activity_ms_ = millis();
+}
+
+void EnergomeraIecBridge::slot_done(uint32_t slot_ms) {
+  if (this->current_ == nullptr)
+    return;
+  this->current_->slots++;
+  this->current_->bus_ms += slot_ms;
+}
+
+void EnergomeraIecBridge::drop_client_() {
+  this->client_->close();
+  this->client_ = nullptr;
+  this->pending_len_ = 0;
+}
+
+// Stats are kept per peer address across connections, the least active peer makes room for a new one
+EnergomeraIecBridge::ClientStats *EnergomeraIecBridge::find_stats_(const char *peer) {
+  for (auto &stats : this->stats_) {
+    if (strncmp(stats.peer, peer, sizeof(stats.peer) - 1) == 0)
+      return &stats;
+  }
+  if (this->stats_.size() < MAX_CLIENT_STATS) {
+    this->stats_.emplace_back();
+  } else {
+    auto least = this->stats_.begin();
+    for (auto it = this->stats_.begin(); it != this->stats_.end(); ++it) {
+      if (it->bus_ms < least->bus_ms)
+        least = it;
+    }
+    *least = ClientStats{};
+    std::rotate(least, least + 1, this->stats_.end());
+  }
+  auto &stats = this->stats_.back();
+  strncpy(stats.peer, peer, sizeof(stats.peer) - 1);
+  return &stats;
+}
+
+}  // namespace energomera_iec
+}  // namespace esphome
+
+#endif  // USE_ENERGOMERA_IEC_SOCKET
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_ENERGOMERA_IEC_SOCKET
+
+#include "esphome/components/socket/socket.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace esphome {
+namespace energomera_iec {
+
+// TCP port for external tools (vendor software, billing head-end) to talk to the meters on the bus.
+// Only the socket side lives here, the component decides when the client gets the bus.
+// One client at a time, others are turned away while it is connected.
+class EnergomeraIecBridge {
+ public:
+  static constexpr size_t MAX_CLIENT_STATS = 4;
+
+  struct ClientStats {
+    char peer[20]{};
+    uint32_t slots{0};   // times the bus was handed to it
+    uint32_t bus_ms{0};  // time it held the bus
+    uint32_t bytes_to_bus{0};
+    uint32_t bytes_from_bus{0};
+  };
+
+  explicit EnergomeraIecBridge(uint16_t port) : port_(port) { this->stats_.reserve(MAX_CLIENT_STATS); }
+
+  void loop();  // accepts clients, reads what they send
+  bool has_client() const { return this->client_ != nullptr; }
+  const char *get_client_name() const { return this->current_ != nullptr ? this->current_->peer : ""; }
+
+  // bytes from the client waiting for the bus
+  size_t pending() const { return this->pending_len_; }
+  const uint8_t *pending_data() const { return this->pending_; }
+  void clear_pending() { this->pending_len_ = 0; }
+
+  void send(const uint8_t *data, size_t len);
+  uint32_t get_last_activity_ms() const { return this->last_activity_ms_; }
+
+  void slot_done(uint32_t slot_ms);
+  const std::vector<ClientStats> &get_stats() const { return this->stats_; }
+  uint32_t get_started_ms() const { return this->started_ms_; }
+
+  void dump_config(const char *tag);
+
+ protected:
+  bool listen_();
+  void accept_();
+  void read_client_();
+  void drop_client_();
+  ClientStats *find_stats_(const char *peer);
+
+  uint16_t port_;
+  std::unique_ptr<socket::Socket> server_;
+  std::unique_ptr<socket::Socket> client_;
+  uint32_t started_ms_{0};
+  uint32_t listen_tried_ms_{0};
+
+  uint8_t pending_[128];
+  size_t pending_len_{0};
+  uint32_t last_activity_ms_{0};
+
+  std::vector<ClientStats> stats_;
+  ClientStats *current_{nullptr};
+};
+
+}  // namespace energomera_iec
+}  // namespace esphome
+
+#endif  // USE_ENERGOMERA_IEC_SOCKET
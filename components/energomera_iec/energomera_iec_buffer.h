@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+namespace esphome {
+namespace energomera_iec {
+
+class EnergomeraIecSensor;
+
+// Readings held back while nobody listens, oldest first. When full the oldest reading is overwritten.
+class ReadingBuffer {
+ public:
+  struct Entry {
+    EnergomeraIecSensor *sensor;
+    float value;
+    uint32_t read_ms;
+    uint32_t timestamp;  // UTC read time, 0 without a time source
+  };
+
+  void init(size_t capacity) {
+    this->entries_.reset(new Entry[capacity]);
+    this->capacity_ = capacity;
+  }
+
+  bool enabled() const { return this->capacity_ > 0; }
+  bool empty() const { return this->size_ == 0; }
+  size_t size() const { return this->size_; }
+  size_t capacity() const { return this->capacity_; }
+  uint32_t get_overwritten() const { return this->overwritten_; }
+
+  void push(EnergomeraIecSensor *sensor, float value, uint32_t read_ms, uint32_t timestamp) {
+    if (this->size_ == this->capacity_) {
+      this->head_ = (this->head_ + 1) % this->capacity_;
+      this->size_--;
+      this->overwritten_++;
+    }
+    this->entries_[(this->head_ + this->size_) % this->capacity_] = {sensor, value, read_ms, timestamp};
+    this->size_++;
+  }
+
+  Entry pop() {
+    Entry entry = this->entries_[this->head_];
+    this->head_ = (this->head_ + 1) % this->capacity_;
+    this->size_--;
+    return entry;
+  }
+
+ protected:
+  std::unique_ptr<Entry[]> entries_;
+  size_t capacity_{0};
+  size_t head_{0};
+  size_t size_{0};
+  uint32_t overwritten_{0};
+};
+
+}  // namespace energomera_iec
+}  // namespace esphome
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+namespace esphome {
+namespace energomera_iec {
+
+// Exact decimal value as read from the meter: mantissa * 10^-decimals.
+// "123456.789" is {123456789, 3}. Keeps all digits of energy counters that a float would lose.
+struct Decimal {
+  static constexpr uint8_t MAX_DIGITS = 18;  // always fits into int64_t
+
+  int64_t mantissa{0};
+  uint8_t decimals{0};
+
+  // Parses [spaces][+|-]digits[.digits]. Returns false on anything else or on too many digits.
+  static bool parse(const char *str, Decimal &value) {
+    while (*str == ' ')
+      str++;
+
+    bool negative = *str == '-';
+    if (*str == '-' || *str == '+')
+      str++;
+
+    int64_t mantissa = 0;
+    uint8_t digits = 0;  // significant ones, leading zeros do not count
+    uint8_t decimals = 0;
+    bool point = false;
+    bool any_digit = false;
+    for (; *str; str++) {
+      if (*str == '.' && !point) {
+        point = true;
+        continue;
+      }
+      if (*str < '0' || *str > '9')
+        return false;
+      any_digit = true;
+      if ((mantissa != 0 || *str != '0') && ++digits > MAX_DIGITS)
+        return false;
+      if (point && ++decimals > MAX_DIGITS)
+        return false;
+      mantissa = mantissa * 10 + (*str - '0');
+    }
+    if (!any_digit)
+      return false;
+
+    value.mantissa = negative ? -mantissa : mantissa;
+    value.decimals = decimals;
+    return true;
+  }
+
+  static int64_t pow10(uint8_t n) {
+    int64_t p = 1;
+    while (n--)
+      p *= 10;
+    return p;
+  }
+
+  // Same value with more fraction digits, false if it does not fit
+  bool rescale(uint8_t to_decimals, int64_t &out) const {
+    if (to_decimals < this->decimals || to_decimals > MAX_DIGITS)
+      return false;
+    int64_t factor = pow10(to_decimals - this->decimals);
+    int64_t limit = INT64_MAX / factor;
+    if (this->mantissa > limit || this->mantissa < -limit)
+      return false;
+    out = this->mantissa * factor;
+    return true;
+  }
+
+  // this - other, exact. False on overflow.
+  bool minus(const Decimal &other, Decimal &out) const {
+    uint8_t decimals = this->decimals > other.decimals ? this->decimals : other.decimals;
+    int64_t a, b;
+    if (!this->rescale(decimals, a) || !other.rescale(decimals, b))
+      return false;
+    if ((b < 0 && a > INT64_MAX + b) || (b > 0 && a < INT64_MIN + b))
+      return false;
+    out.mantissa = a - b;
+    out.decimals = decimals;
+    return true;
+  }
+
+  // this + other, exact. False on overflow.
+  bool plus(const Decimal &other, Decimal &out) const {
+    uint8_t decimals = this->decimals > other.decimals ? this->decimals : other.decimals;
+    int64_t a, b;
+    if (!this->rescale(decimals, a) || !other.rescale(decimals, b))
+      return false;
+    if ((b > 0 && a > INT64_MAX - b) || (b < 0 && a < INT64_MIN - b))
+      return false;
+    out.mantissa = a + b;
+    out.decimals = decimals;
+    return true;
+  }
+
+  // For computed values that are not exact anyway, like rates and ratios
+  static Decimal from_double(double value, uint8_t decimals) {
+    Decimal d;
+    d.mantissa = llround(value * (double) pow10(decimals));
+    d.decimals = decimals;
+    return d;
+  }
+
+  // Conversion happens only when the value leaves the component
+  double to_double() const { return (double) this->mantissa / (double) pow10(this->decimals); }
+  float to_float() const { return (float) this->to_double(); }
+};
+
+}  // namespace energomera_iec
+}  // namespace esphome
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace esphome {
+namespace energomera_iec {
+
+// Settings a meter model works best with. Baud rate is not here, the meter reports its maximum
+// in the identification: "/EKT5CE102Mv01", '5' is 9600.
+struct MeterProfile {
+  const char *model;  // follows "/EKT<baud>" in the identification
+  uint16_t receive_timeout_ms;
+  uint16_t delay_between_requests_ms;  // single-phase meters need longer to get ready for the next request
+  uint8_t date_len;                    // DATE_(w.dd.mm.yy) or DATE_(0w.dd.mm.yy)
+};
+
+static const MeterProfile METER_PROFILES[] = {
+    {"CE102M", 500, 150, 10}, {"CE102", 500, 150, 10}, {"CE207", 500, 150, 10}, {"CE208", 500, 150, 10},
+    {"CE301", 500, 50, 11},   {"CE303", 500, 50, 11},  {"CE307", 500, 50, 11},  {"CE308", 500, 50, 11},
+};
+
+// Identification is "/" + 3 letters of manufacturer + baud rate character + model
+static const size_t IDENTITY_MODEL_OFFSET = 5;
+
+inline const MeterProfile *find_meter_profile(const char *model) {
+  for (const auto &profile : METER_PROFILES) {
+    if (strncmp(model, profile.model, strlen(profile.model)) == 0)
+      return &profile;
+  }
+  return nullptr;
+}
+
+inline const MeterProfile *find_meter_profile_by_identity(const char *identity) {
+  if (identity[0] != '/' || strlen(identity) <= IDENTITY_MODEL_OFFSET)
+    return nullptr;
+  return find_meter_profile(identity + IDENTITY_MODEL_OFFSET);
+}
+
+}  // namespace energomera_iec
+}  // namespace esphome
@@ -0,0 +1,84 @@
+#include "esphome/core/log.h"
+#include "energomera_iec_sensor.h"
+
+namespace esphome {
+namespace energomera_iec {
+
+static const char *const TAG = "energomera_iec.derived";
+
+void EnergomeraIecDerivedSensor::source_updated(EnergomeraIecSensor *source) {
+  switch (this->type_) {
+    case DerivedType::DELTA:
+    case DerivedType::RATE:
+      this->update_counter_(source);
+      break;
+    case DerivedType::SUM:
+      this->update_sum_();
+      break;
+    case DerivedType::RATIO:
+      this->update_ratio_();
+      break;
+  }
+}
+
+// Uses the time each reading was taken, so a skipped poll widens the interval instead of skewing the result
+void EnergomeraIecDerivedSensor::update_counter_(EnergomeraIecSensor *source) {
+  const Decimal &value = source->get_decimal();
+  uint32_t read_ms = source->get_read_ms();
+  uint32_t elapsed_ms = read_ms - this->base_ms_;
+
+  Decimal delta;
+  bool rebase = !this->has_base_;
+  if (!rebase && this->max_gap_ms_ > 0 && elapsed_ms > this->max_gap_ms_) {
+    ESP_LOGD(TAG, "'%s': %u ms since previous reading, starting over", this->get_name().c_str(), elapsed_ms);
+    rebase = true;
+  } else if (!rebase && !value.minus(this->base_, delta)) {
+    rebase = true;
+  } else if (!rebase && delta.mantissa < 0) {
+    ESP_LOGW(TAG, "'%s': counter went backwards, meter reset or replaced? Starting over", this->get_name().c_str());
+    rebase = true;
+  }
+
+  if (rebase || elapsed_ms == 0) {
+    this->has_base_ = true;
+    this->base_ = value;
+    this->base_ms_ = read_ms;
+    return;
+  }
+  this->base_ = value;
+  this->base_ms_ = read_ms;
+
+  if (this->type_ == DerivedType::DELTA) {
+    this->set_computed_(delta);
+  } else {
+    double rate = delta.to_double() * this->time_unit_s_ * 1000.0 / elapsed_ms;
+    this->set_computed_(Decimal::from_double(rate, COMPUTED_DECIMALS));
+  }
+}
+
+// Sources are reset at the start of each poll cycle, so a source that failed this cycle holds the result back
+void EnergomeraIecDerivedSensor::update_sum_() {
+  Decimal sum;
+  for (auto *source : this->sources_) {
+    if (!source->has_value())
+      return;  // wait for all of them to be read in this cycle
+    if (!sum.plus(source->get_decimal(), sum)) {
+      ESP_LOGW(TAG, "'%s': sum does not fit", this->get_name().c_str());
+      return;
+    }
+  }
+  this->set_computed_(sum);
+}
+
+void EnergomeraIecDerivedSensor::update_ratio_() {
+  if (this->sources_.size() != 2 || !this->sources_[0]->has_value() || !this->sources_[1]->has_value())
+    return;
+  double denominator = this->sources_[1]->get_decimal().to_double();
+  if (denominator == 0)
+    return;
+  double ratio = this->sources_[0]->get_decimal().to_double() / denominator;
+  this->set_computed_(Decimal::from_double(ratio, COMPUTED_DECIMALS));
+}
+
+}  // namespace energomera_iec
+}  // namespace esphome
@@ -1,16 +1,23 @@
 #pragma once
 
+#include "esphome/core/hal.h"
+#include "esphome/core/preferences.h"
 #include "esphome/components/sensor/sensor.h"
 #ifdef USE_TEXT_SENSOR
 #include "esphome/components/text_sensor/text_sensor.h"
 #endif
 
+#include <vector>
+
+#include "energomera_iec_decimal.h"
+#include "energomera_iec_aggregate.h"
+
 namespace esphome {
 namespace energomera_iec {
 
 static constexpr uint8_t MAX_TRIES = 10;
 
-enum SensorType { SENSOR, TEXT_SENSOR };
+enum SensorType { SENSOR, TEXT_SENSOR, SENSOR_GROUP };
 
 class EnergomeraIecSensorBase {
  public:
@@ -27,7 +34,7 @@ class EnergomeraIecSensorBase {
     // But after checks in sensor.py it only can be 2 and 3
     request_ = req;
 
-    char *p = strchr(req, '(');
+    const char *p = strchr(req, '(');
     if (p != nullptr) {
       size_t len = p - req;
       function_.assign(req, len);
@@ -36,19 +43,39 @@ class EnergomeraIecSensorBase {
   const std::string &get_request() const { return request_; }
   const std::string &get_function() const { return function_; }
 
+  // R1 request frame, shared by sensors with the same request
+  void set_frame(const uint8_t *frame, uint8_t size) {
+    frame_ = frame;
+    frame_size_ = size;
+  }
+  const uint8_t *get_frame() const { return frame_; }
+  uint8_t get_frame_size() const { return frame_size_; }
+
   void set_index(const uint8_t idx) { idx_ = idx; };
   uint8_t get_index() const { return idx_; };
   
   void set_sub_index(const uint8_t sub_idx) { sub_idx_ = sub_idx; };
   uint8_t get_sub_index() const { return sub_idx_; };
 
-  void reset() {
+  // start of a poll cycle: has_value() is false until the value is read again
+  virtual void reset() {
     has_value_ = false;
     tries_ = 0;
   }
 
   bool has_value() { return has_value_; }
 
+  uint32_t get_value_age_ms() const { return ever_updated_ ? millis() - last_update_ms_ : UINT32_MAX; }
+
+  // when the value was read: millis() and UTC time, 0 if no time source. Set before the value.
+  void set_read_time(uint32_t read_ms, uint32_t timestamp) {
+    read_ms_ = read_ms;
+    timestamp_ = timestamp;
+  }
+  uint32_t get_read_ms() const { return read_ms_; }
+  void set_timestamp(uint32_t timestamp) { timestamp_ = timestamp; }
+  uint32_t get_timestamp() const { return timestamp_; }
+
   void record_failure() {
     if (tries_ < MAX_TRIES) {
       tries_++;
@@ -61,25 +88,175 @@ class EnergomeraIecSensorBase {
  protected:
   std::string request_;
   std::string function_;
+  const uint8_t *frame_{nullptr};
+  uint8_t frame_size_{0};
   uint8_t idx_{1};
   uint8_t sub_idx_{0};
-  bool has_value_;
+  bool has_value_{false};
   uint8_t tries_{0};
+  bool ever_updated_{false};
+  uint32_t last_update_ms_{0};
+  uint32_t read_ms_{0};
+  uint32_t timestamp_{0};
+
+  void mark_updated_() {
+    has_value_ = true;
+    tries_ = 0;
+    ever_updated_ = true;
+    last_update_ms_ = millis();
+  }
 };
 
+class EnergomeraIecDerivedSensor;
+
 class EnergomeraIecSensor : public EnergomeraIecSensorBase, public sensor::Sensor {
  public:
   SensorType get_type() const override { return SENSOR; }
-  void publish() override { publish_state(value_); }
+  void publish() override { publish_state(get_value()); }
+  void reset() override;
 
-  void set_value(float value) {
-    value_ = value;
-    has_value_ = true;
-    tries_ = 0;
+  float get_value() const { return value_.to_float(); }
+  const Decimal &get_decimal() const { return value_; }
+
+  // Exact change since the previous reading, false if there is no previous one
+  bool get_delta(Decimal &delta) const { return has_previous_ && value_.minus(previous_, delta); }
+
+  // how long a reading may wait in the store-and-forward buffer, 0 = no limit
+  void set_retention_ms(uint32_t retention_ms) { retention_ms_ = retention_ms; }
+  uint32_t get_retention_ms() const { return retention_ms_; }
+
+  uint32_t get_last_update_ms() const { return last_update_ms_; }
+
+  void set_value(const Decimal &value);
+
+  void add_derived(EnergomeraIecDerivedSensor *derived) { derived_.push_back(derived); }
+  const std::vector<EnergomeraIecDerivedSensor *> &get_derived() const { return derived_; }
+
+  void set_aggregate(EnergomeraIecAggregate *aggregate) { aggregate_ = aggregate; }
+  // with an aggregate each fast sample stays on the device unless asked for
+  void set_publish_samples(bool publish_samples) { publish_samples_ = publish_samples; }
+  bool get_publish_samples() const { return publish_samples_; }
+
+  // Last published value survives reboot and is published again right at boot, until a fresh reading comes
+  void setup_restore(uint32_t hash) {
+    pref_ = global_preferences->make_preference<float>(hash);
+    restore_enabled_ = true;
+    float value;
+    if (pref_.load(&value) && !std::isnan(value)) {
+      restored_ = true;
+      publish_state(value);
+    }
   }
+  void save_value() {
+    if (!restore_enabled_)
+      return;
+    float value = get_value();
+    pref_.save(&value);
+    restored_ = false;
+  }
+  // value is from before the reboot, not read yet
+  bool is_restored() const { return restored_; }
 
  protected:
-  float value_;
+  Decimal value_;
+  Decimal previous_;
+  bool has_previous_{false};
+  std::vector<EnergomeraIecDerivedSensor *> derived_;  // computed from this one
+  EnergomeraIecAggregate *aggregate_{nullptr};
+  bool publish_samples_{true};
+  ESPPreferenceObject pref_;
+  bool restore_enabled_{false};
+  bool restored_{false};
+  uint32_t retention_ms_{0};
+};
+
+enum class DerivedType : uint8_t { DELTA, RATE, SUM, RATIO };
+
+// Sensor computed on device from other sensors each time one of them gets a new reading.
+// DELTA and RATE follow a single counter, SUM adds all sources, RATIO divides the first source by the second.
+class EnergomeraIecDerivedSensor : public EnergomeraIecSensor {
+ public:
+  void set_derived_type(DerivedType type) { type_ = type; }
+  void add_source(EnergomeraIecSensor *source) {
+    sources_.push_back(source);
+    source->add_derived(this);
+  }
+  void set_time_unit_s(uint32_t seconds) { time_unit_s_ = seconds; }
+  void set_max_gap_ms(uint32_t max_gap_ms) { max_gap_ms_ = max_gap_ms; }
+
+  void source_updated(EnergomeraIecSensor *source);
+
+  // true once after each new value, so a value is published once however many sources changed
+  bool take_pending() {
+    bool pending = pending_;
+    pending_ = false;
+    return pending;
+  }
+
+ protected:
+  static constexpr uint8_t COMPUTED_DECIMALS = 6;
+
+  DerivedType type_{DerivedType::SUM};
+  std::vector<EnergomeraIecSensor *> sources_;
+  uint32_t time_unit_s_{3600};
+  uint32_t max_gap_ms_{0};  // 0 = any gap is bridged
+  bool pending_{false};
+
+  // counter state for DELTA and RATE
+  bool has_base_{false};
+  Decimal base_;
+  uint32_t base_ms_{0};
+
+  void update_counter_(EnergomeraIecSensor *source);
+  void update_sum_();
+  void update_ratio_();
+  void set_computed_(const Decimal &value) {
+    set_value(value);
+    pending_ = true;
+  }
+};
+
+inline void EnergomeraIecSensor::reset() {
+  EnergomeraIecSensorBase::reset();
+  for (auto *derived : derived_)
+    derived->reset();
+}
+
+inline void EnergomeraIecSensor::set_value(const Decimal &value) {
+  if (ever_updated_) {
+    previous_ = value_;
+    has_previous_ = true;
+  }
+  value_ = value;
+  mark_updated_();
+  if (aggregate_ != nullptr)
+    aggregate_->add(value.to_double(), last_update_ms_);
+  for (auto *derived : derived_)
+    derived->source_updated(this);
+}
+
+// Several numeric sensors fed from one request, e.g. all tariffs of ET0PE() or all phases of VOLTA().
+// Only the group holds the request and sits in the request map, the sensors just keep their index and value.
+class EnergomeraIecSensorGroup : public EnergomeraIecSensorBase {
+ public:
+  SensorType get_type() const override { return SENSOR_GROUP; }
+  void publish() override {
+    for (auto *sensor : sensors_)
+      sensor->publish();
+  }
+  void reset() override {
+    EnergomeraIecSensorBase::reset();
+    for (auto *sensor : sensors_)
+      sensor->reset();
+  }
+
+  void add_sensor(EnergomeraIecSensor *sensor) { sensors_.push_back(sensor); }
+  const std::vector<EnergomeraIecSensor *> &get_sensors() const { return sensors_; }
+
+  void values_updated() { mark_updated_(); }
+
+ protected:
+  std::vector<EnergomeraIecSensor *> sensors_;
 };
 
 #ifdef USE_TEXT_SENSOR
@@ -90,8 +267,7 @@ class EnergomeraIecTextSensor : public EnergomeraIecSensorBase, public text_sens
 
   void set_value(const char *value) {
     value_ = value;
-    has_value_ = true;
-    tries_ = 0;
+    mark_updated_();
   }
 
  protected:
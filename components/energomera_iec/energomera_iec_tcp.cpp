@@ -0,0 +1,159 @@
+#include "energomera_iec_tcp.h"
+
+#ifdef USE_ENERGOMERA_IEC_SOCKET
+
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+
+#include <cerrno>
+#include <map>
+#include <string>
+#include <sys/select.h>
+
+namespace esphome {
+namespace energomera_iec {
+
+static const char *const TAG = "energomera_iec.tcp";
+
+static constexpr uint32_t CONNECT_TIMEOUT_MS = 5000;
+
+void EnergomeraIecTcpTransport::dump_config(const char *tag) {
+  ESP_LOGCONFIG(tag, "  Transport: TCP %s:%u", this->host_.c_str(), this->port_);
+  ESP_LOGCONFIG(tag, "  Latency allowance: %ums", this->latency_ms_);
+}
+
+void *EnergomeraIecTcpTransport::find_bus_(const std::string &host, uint16_t port) {
+  static std::map<std::string, uint8_t> buses;  // NOLINT
+  return &buses[host + ":" + std::to_string(port)];
+}
+
+bool EnergomeraIecTcpTransport::is_ready() {
+  if (this->socket_ == nullptr) {
+    this->connect_();
+    return false;
+  }
+  if (!this->connected_) {
+    int8_t result = this->check_connect_();
+    if (result > 0) {
+      ESP_LOGD(TAG, "Connected to %s:%u", this->host_.c_str(), this->port_);
+      this->connected_ = true;
+    } else if (result < 0) {
+      this->disconnect_();
+    } else if (millis() - this->connect_started_ms_ > CONNECT_TIMEOUT_MS) {
+      ESP_LOGW(TAG, "Connection to %s:%u timed out", this->host_.c_str(), this->port_);
+      this->disconnect_();
+    }
+  }
+  return this->connected_;
+}
+
+// Non-blocking connect is over once the socket is writable, SO_ERROR tells how it went.
+// Returns 1 when connected, -1 when failed, 0 while still in progress.
+int8_t EnergomeraIecTcpTransport::check_connect_() {
+  int fd = this->socket_->get_fd();
+  if (fd < 0) {
+    // no descriptor to wait on, the peer is known once connected
+    struct sockaddr_storage peer;
+    socklen_t len = sizeof(peer);
+    return this->socket_->getpeername((struct sockaddr *) &peer, &len) == 0 ? 1 : 0;
+  }
+  fd_set writable;
+  FD_ZERO(&writable);
+  FD_SET(fd, &writable);
+  struct timeval no_wait {};
+  int ready = select(fd + 1, nullptr, &writable, nullptr, &no_wait);
+  if (ready == 0)
+    return 0;
+  int err = 0;
+  socklen_t len = sizeof(err);
+  if (ready < 0 || this->socket_->getsockopt(SOL_SOCKET, SO_ERROR, &err, &len) != 0)
+    err = errno;
+  if (err != 0) {
+    ESP_LOGW(TAG, "Connection to %s:%u failed, errno %d", this->host_.c_str(), this->port_, err);
+    return -1;
+  }
+  return 1;
+}
+
+bool EnergomeraIecTcpTransport::connect_() {
+  ESP_LOGD(TAG, "Connecting to %s:%u", this->host_.c_str(), this->port_);
+  this->socket_ = socket::socket_ip(SOCK_STREAM, IPPROTO_TCP);
+  if (this->socket_ == nullptr) {
+    ESP_LOGW(TAG, "Cannot create socket");
+    return false;
+  }
+  this->socket_->setblocking(false);
+  int enable = 1;
+  this->socket_->setsockopt(IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(int));
+
+  struct sockaddr_storage addr;
+  socklen_t addr_len = socket::set_sockaddr((struct sockaddr *) &addr, sizeof(addr), this->host_, this->port_);
+  if (addr_len == 0) {
+    ESP_LOGE(TAG, "Invalid gateway address '%s'", this->host_.c_str());
+    this->disconnect_();
+    return false;
+  }
+  if (this->socket_->connect((struct sockaddr *) &addr, addr_len) != 0 && errno != EINPROGRESS) {
+    ESP_LOGW(TAG, "Connection to %s:%u failed, errno %d", this->host_.c_str(), this->port_, errno);
+    this->disconnect_();
+    return false;
+  }
+  this->connect_started_ms_ = millis();
+  this->rx_head_ = 0;
+  this->rx_len_ = 0;
+  return true;
+}
+
+void EnergomeraIecTcpTransport::disconnect_() {
+  if (this->socket_ != nullptr) {
+    this->socket_->close();
+    this->socket_ = nullptr;
+  }
+  this->connected_ = false;
+}
+
+void EnergomeraIecTcpTransport::fill_rx_buffer_() {
+  if (!this->connected_ || this->rx_head_ < this->rx_len_)
+    return;
+  this->rx_head_ = 0;
+  this->rx_len_ = 0;
+  ssize_t read = this->socket_->read(this->rx_buf_, sizeof(this->rx_buf_));
+  if (read > 0) {
+    this->rx_len_ = read;
+  } else if (read == 0) {
+    ESP_LOGW(TAG, "Gateway closed connection");
+    this->disconnect_();
+  } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+    ESP_LOGW(TAG, "Read failed, errno %d", errno);
+    this->disconnect_();
+  }
+}
+
+int EnergomeraIecTcpTransport::available() {
+  this->fill_rx_buffer_();
+  return this->rx_len_ - this->rx_head_;
+}
+
+bool EnergomeraIecTcpTransport::read_one_byte(uint8_t *data) {
+  if (this->available() < 1)
+    return false;
+  *data = this->rx_buf_[this->rx_head_++];
+  return true;
+}
+
+void EnergomeraIecTcpTransport::write_array(const uint8_t *data, size_t len) {
+  if (!this->connected_) {
+    ESP_LOGW(TAG, "Not connected, %u bytes dropped", (unsigned) len);
+    return;
+  }
+  ssize_t written = this->socket_->write(data, len);
+  if (written != (ssize_t) len) {
+    ESP_LOGW(TAG, "Write failed (%d of %u bytes), errno %d", (int) written, (unsigned) len, errno);
+    this->disconnect_();
+  }
+}
+
+}  // namespace energomera_iec
+}  // namespace esphome
+
+#endif  // USE_ENERGOMERA_IEC_SOCKET
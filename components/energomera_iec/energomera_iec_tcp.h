@@ -0,0 +1,65 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_ENERGOMERA_IEC_SOCKET
+
+#include "esphome/components/socket/socket.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "energomera_iec_transport.h"
+
+namespace esphome {
+namespace energomera_iec {
+
+// Meter(s) behind an RS485-to-TCP gateway in transparent mode.
+// Serial settings belong to the gateway, so baud rate can not be switched during a session.
+class EnergomeraIecTcpTransport final : public EnergomeraIecTransport {
+ public:
+  EnergomeraIecTcpTransport(const std::string &host, uint16_t port, uint32_t latency_ms)
+      : host_(host), port_(port), latency_ms_(latency_ms), bus_(find_bus_(host, port)) {}
+
+  bool is_ready() override;
+  bool is_connecting() const override { return this->socket_ != nullptr && !this->connected_; }
+  int available() override;
+  bool read_one_byte(uint8_t *data) override;
+  void write_array(const uint8_t *data, size_t len) override;
+  void flush() override {}
+  void reset() override { this->disconnect_(); }
+
+  bool supports_baud_rate_change() const override { return false; }
+  void update_baudrate(uint32_t baudrate) override {}
+
+  uint32_t get_timeout_margin_ms() const override { return this->latency_ms_; }
+  // every connection to the same gateway port ends up on the same RS485 line
+  void *bus_id() override { return this->bus_; }
+  void dump_config(const char *tag) override;
+
+ protected:
+  bool connect_();
+  int8_t check_connect_();
+  void disconnect_();
+  static void *find_bus_(const std::string &host, uint16_t port);
+  void fill_rx_buffer_();
+
+  std::string host_;
+  uint16_t port_;
+  uint32_t latency_ms_;
+  void *bus_;
+
+  std::unique_ptr<socket::Socket> socket_;
+  bool connected_{false};
+  uint32_t connect_started_ms_{0};
+
+  uint8_t rx_buf_[64];
+  size_t rx_head_{0};
+  size_t rx_len_{0};
+};
+
+}  // namespace energomera_iec
+}  // namespace esphome
+
+#endif  // USE_ENERGOMERA_IEC_SOCKET
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+
+#include "esphome/core/hal.h"
+
+namespace esphome {
+namespace energomera_iec {
+
+// Last frames seen on the wire, oldest first. Recording is a plain copy, frames are only formatted when dumped.
+class FrameTrace {
+ public:
+  static constexpr size_t MAX_FRAME_BYTES = 64;  // longer frames are cut
+
+  enum class Direction : uint8_t { TX, RX };
+  enum class Check : uint8_t { NONE, BCC_OK, BCC_FAILED, INCOMPLETE };
+
+  struct Entry {
+    uint32_t ms;
+    uint16_t size;  // as on the wire
+    uint8_t stored;
+    Direction direction;
+    uint8_t state;
+    Check check;
+    uint8_t data[MAX_FRAME_BYTES];
+  };
+
+  void init(size_t capacity) {
+    this->entries_.reset(new Entry[capacity]);
+    this->capacity_ = capacity;
+    this->enabled_ = true;
+  }
+
+  bool enabled() const { return this->enabled_; }
+  void set_enabled(bool enabled) { this->enabled_ = enabled && this->capacity_ > 0; }
+  size_t size() const { return this->size_; }
+  size_t capacity() const { return this->capacity_; }
+
+  void record(Direction direction, uint8_t state, const uint8_t *data, size_t size, Check check = Check::NONE) {
+    Entry *entry;
+    if (this->size_ == this->capacity_) {
+      entry = &this->entries_[this->head_];
+      this->head_ = (this->head_ + 1) % this->capacity_;
+    } else {
+      entry = &this->entries_[(this->head_ + this->size_) % this->capacity_];
+      this->size_++;
+    }
+    entry->ms = millis();
+    entry->size = size;
+    entry->stored = size < MAX_FRAME_BYTES ? size : MAX_FRAME_BYTES;
+    entry->direction = direction;
+    entry->state = state;
+    entry->check = check;
+    memcpy(entry->data, data, entry->stored);
+  }
+
+  // BCC is verified after the frame was recorded
+  void set_last_check(Check check) {
+    if (this->size_ > 0)
+      this->entries_[(this->head_ + this->size_ - 1) % this->capacity_].check = check;
+  }
+
+  const Entry &get(size_t idx) const { return this->entries_[(this->head_ + idx) % this->capacity_]; }
+
+  void clear() {
+    this->head_ = 0;
+    this->size_ = 0;
+  }
+
+ protected:
+  std::unique_ptr<Entry[]> entries_;
+  size_t capacity_{0};
+  size_t head_{0};
+  size_t size_{0};
+  bool enabled_{false};
+};
+
+}  // namespace energomera_iec
+}  // namespace esphome
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace esphome {
+namespace energomera_iec {
+
+// Byte stream to the meter(s) underneath the protocol engine.
+// All calls are non-blocking, the state machine polls available() from loop().
+class EnergomeraIecTransport {
+ public:
+  virtual ~EnergomeraIecTransport() = default;
+
+  // false while the link is being (re)established, sessions are not started then
+  virtual bool is_ready() { return true; }
+  // link is on its way up, worth asking is_ready() again shortly
+  virtual bool is_connecting() const { return false; }
+
+  virtual int available() = 0;
+  virtual bool read_one_byte(uint8_t *data) = 0;
+  virtual void write_array(const uint8_t *data, size_t len) = 0;
+  // wait until transmission is complete, flow control pin is released after that
+  virtual void flush() = 0;
+
+  // drop whatever state the link is in and start over, first step of failure recovery
+  virtual void reset() {}
+
+  virtual bool supports_baud_rate_change() const { return true; }
+  virtual void update_baudrate(uint32_t baudrate) = 0;
+
+  // added to receive timeout to cover transport latency
+  virtual uint32_t get_timeout_margin_ms() const { return 0; }
+
+  // identifies the shared physical bus, used for bus locking and staggering
+  virtual void *bus_id() = 0;
+
+  virtual void dump_config(const char *tag) = 0;
+};
+
+}  // namespace energomera_iec
+}  // namespace esphome
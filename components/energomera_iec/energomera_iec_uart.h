@@ -1,5 +1,11 @@
 #pragma once
 #include <cstdint>
+#include <memory>
+
+#include "esphome/core/log.h"
+#include "esphome/core/helpers.h"
+#include "esphome/components/uart/uart.h"
+#include "energomera_iec_transport.h"
 
 #ifdef USE_ESP32
 #include "esphome/components/uart/uart_component_esp_idf.h"
@@ -136,5 +142,57 @@ class EnergomeraIecUart final : public uart::IDFUARTComponent {
 };
 #endif
 
+class EnergomeraIecUartTransport final : public EnergomeraIecTransport {
+ public:
+  explicit EnergomeraIecUartTransport(uart::UARTComponent *uart) : uart_(uart) {
+#ifdef USE_ESP32
+    iuart_ = make_unique<EnergomeraIecUart>(*static_cast<uart::IDFUARTComponent *>(uart));
+#endif
+#ifdef USE_ESP8266
+    iuart_ = make_unique<EnergomeraIecUart>(*static_cast<uart::ESP8266UartComponent *>(uart));
+#endif
+  }
+
+  int available() override { return this->uart_->available(); }
+
+  bool read_one_byte(uint8_t *data) override {
+    if (this->uart_->available() < 1)
+      return false;
+#if defined(USE_ESP32) || defined(USE_ESP8266)
+    return this->iuart_->read_one_byte(data);
+#else
+    return this->uart_->read_array(data, 1);
+#endif
+  }
+
+  void write_array(const uint8_t *data, size_t len) override { this->uart_->write_array(data, len); }
+  void flush() override { this->uart_->flush(); }
+
+  // reapplies configured port settings, this also brings back the configured baud rate
+  void reset() override {
+    this->uart_->flush();
+    this->uart_->load_settings(false);
+  }
+
+  void update_baudrate(uint32_t baudrate) override {
+#if defined(USE_ESP32) || defined(USE_ESP8266)
+    this->iuart_->update_baudrate(baudrate);
+#else
+    this->uart_->set_baud_rate(baudrate);
+    this->uart_->load_settings(false);
+#endif
+  }
+
+  void *bus_id() override { return this->uart_; }
+
+  void dump_config(const char *tag) override { ESP_LOGCONFIG(tag, "  Transport: UART %p", this->uart_); }
+
+ protected:
+  uart::UARTComponent *uart_;
+#if defined(USE_ESP32) || defined(USE_ESP8266)
+  std::unique_ptr<EnergomeraIecUart> iuart_;
+#endif
+};
+
 }  // namespace energomera_iec
 }  // namespace esphome
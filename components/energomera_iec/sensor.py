@@ -2,7 +2,18 @@ import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import sensor
 from esphome.const import (
+    CONF_ID,
+    CONF_ADDRESS,
     CONF_INDEX,
+    CONF_TYPE,
+    CONF_TIME_UNIT,
+    CONF_MIN,
+    CONF_MAX,
+    CONF_COUNT,
+    CONF_UNIT_OF_MEASUREMENT,
+    CONF_ACCURACY_DECIMALS,
+    CONF_DEVICE_CLASS,
+    STATE_CLASS_MEASUREMENT,
 )
 from . import (
     EnergomeraIec,
@@ -10,40 +21,240 @@ from . import (
     energomera_iec_ns,
     CONF_REQUEST,
     CONF_SUB_INDEX,
+    CONF_RETENTION,
     validate_request_format,
     DEFAULTS_MAX_SENSOR_INDEX,
+    validate_meter_address,
+    final_validate_sensor_meter_address,
 )
 
 EnergomeraIecSensor = energomera_iec_ns.class_("EnergomeraIecSensor", sensor.Sensor)
+EnergomeraIecDerivedSensor = energomera_iec_ns.class_(
+    "EnergomeraIecDerivedSensor", EnergomeraIecSensor
+)
+EnergomeraIecSensorGroup = energomera_iec_ns.class_("EnergomeraIecSensorGroup")
+
+CONF_DERIVED = "derived"
+CONF_VALUES = "values"
+CONF_SOURCES = "sources"
+CONF_MAX_GAP = "max_gap"
+
+DerivedType = energomera_iec_ns.enum("DerivedType", is_class=True)
+DERIVED_TYPES = {
+    "delta": DerivedType.DELTA,
+    "rate": DerivedType.RATE,
+    "sum": DerivedType.SUM,
+    "ratio": DerivedType.RATIO,
+}
+TIME_UNITS = {"s": 1, "min": 60, "h": 3600}
+
+
+def validate_derived(config):
+    derived_type = config[CONF_TYPE]
+    count = len(config[CONF_SOURCES])
+    if derived_type in ("delta", "rate") and count != 1:
+        raise cv.Invalid(f"'{derived_type}' takes exactly one source")
+    if derived_type == "ratio" and count != 2:
+        raise cv.Invalid("'ratio' takes exactly two sources: numerator and denominator")
+    if derived_type == "sum" and count < 2:
+        raise cv.Invalid("'sum' takes at least two sources")
+    if derived_type not in ("delta", "rate") and CONF_MAX_GAP in config:
+        raise cv.Invalid(f"'{CONF_MAX_GAP}' is only used by 'delta' and 'rate'")
+    return config
+
+
+DERIVED_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Required(CONF_TYPE): cv.one_of(*DERIVED_TYPES, lower=True),
+            cv.Required(CONF_SOURCES): cv.ensure_list(cv.use_id(EnergomeraIecSensor)),
+            cv.Optional(CONF_TIME_UNIT, default="h"): cv.one_of(*TIME_UNITS),
+            cv.Optional(CONF_MAX_GAP): cv.positive_time_period_milliseconds,
+        }
+    ),
+    validate_derived,
+)
+
+
+EnergomeraIecAggregate = energomera_iec_ns.class_("EnergomeraIecAggregate")
+
+CONF_AGGREGATE = "aggregate"
+CONF_WINDOW = "window"
+CONF_MEAN = "mean"
+CONF_LAST = "last"
+CONF_PUBLISH_SAMPLES = "publish_samples"
+AGGREGATE_SENSORS = [CONF_MIN, CONF_MAX, CONF_MEAN, CONF_LAST, CONF_COUNT]
+# aggregates take these from the polled sensor unless set explicitly
+INHERITED_KEYS = [CONF_UNIT_OF_MEASUREMENT, CONF_ACCURACY_DECIMALS, CONF_DEVICE_CLASS]
+
+AGGREGATE_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.declare_id(EnergomeraIecAggregate),
+            cv.Required(CONF_WINDOW): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(min=cv.TimePeriod(seconds=1)),
+            ),
+            cv.Optional(CONF_PUBLISH_SAMPLES, default=False): cv.boolean,
+            cv.Optional(CONF_MIN): sensor.sensor_schema(
+                state_class=STATE_CLASS_MEASUREMENT
+            ),
+            cv.Optional(CONF_MAX): sensor.sensor_schema(
+                state_class=STATE_CLASS_MEASUREMENT
+            ),
+            cv.Optional(CONF_MEAN): sensor.sensor_schema(
+                state_class=STATE_CLASS_MEASUREMENT
+            ),
+            cv.Optional(CONF_LAST): sensor.sensor_schema(
+                state_class=STATE_CLASS_MEASUREMENT
+            ),
+            cv.Optional(CONF_COUNT): sensor.sensor_schema(
+                accuracy_decimals=0, state_class=STATE_CLASS_MEASUREMENT
+            ),
+        }
+    ),
+    cv.has_at_least_one_key(*AGGREGATE_SENSORS),
+)
+
+
+def validate_derived_sensor(config):
+    if config[CONF_ID] in config[CONF_DERIVED][CONF_SOURCES]:
+        raise cv.Invalid("Derived sensor can not be its own source")
+    return config
 
 
-CONFIG_SCHEMA = cv.All(
+SENSOR_SCHEMA = sensor.sensor_schema(
+    EnergomeraIecSensor,
+).extend(
+    {
+        cv.GenerateID(CONF_ENERGOMERA_IEC_ID): cv.use_id(EnergomeraIec),
+        cv.Required(CONF_REQUEST): cv.All(cv.string, validate_request_format),
+        cv.Optional(CONF_INDEX, default=1): cv.int_range(
+            min=1, max=DEFAULTS_MAX_SENSOR_INDEX
+        ),
+        cv.Optional(CONF_SUB_INDEX, default=0): cv.int_range(min=0, max=255),
+        cv.Optional(CONF_ADDRESS): cv.All(cv.string, validate_meter_address),
+        cv.Optional(CONF_RETENTION): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_AGGREGATE): AGGREGATE_SCHEMA,
+    }
+)
+
+# Computed from other sensors, no request of its own. A subclass of
+# EnergomeraIecSensor, so it is still a valid source for other derived sensors.
+DERIVED_SENSOR_SCHEMA = cv.All(
     sensor.sensor_schema(
-        EnergomeraIecSensor,
+        EnergomeraIecDerivedSensor,
     ).extend(
         {
             cv.GenerateID(CONF_ENERGOMERA_IEC_ID): cv.use_id(EnergomeraIec),
-            cv.Required(CONF_REQUEST): cv.All(cv.string, validate_request_format),
-            cv.Optional(CONF_INDEX, default=1): cv.int_range(
-                min=1, max=DEFAULTS_MAX_SENSOR_INDEX
-            ),
-            cv.Optional(CONF_SUB_INDEX, default=0): cv.int_range(
-                min=0, max=255
-            ),
+            cv.Required(CONF_DERIVED): DERIVED_SCHEMA,
+            cv.Optional(CONF_RETENTION): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_AGGREGATE): AGGREGATE_SCHEMA,
         }
     ),
-    cv.has_exactly_one_key(CONF_REQUEST),
+    validate_derived_sensor,
+)
+
+# One request, several values. Sensors share the request, see EnergomeraIecSensorGroup.
+GROUP_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(EnergomeraIecSensorGroup),
+        cv.GenerateID(CONF_ENERGOMERA_IEC_ID): cv.use_id(EnergomeraIec),
+        cv.Required(CONF_REQUEST): cv.All(cv.string, validate_request_format),
+        cv.Optional(CONF_ADDRESS): cv.All(cv.string, validate_meter_address),
+        cv.Required(CONF_VALUES): cv.All(
+            cv.ensure_list(
+                sensor.sensor_schema(EnergomeraIecSensor).extend(
+                    {
+                        cv.Optional(CONF_INDEX, default=1): cv.int_range(
+                            min=1, max=DEFAULTS_MAX_SENSOR_INDEX
+                        ),
+                        cv.Optional(CONF_SUB_INDEX, default=0): cv.int_range(
+                            min=0, max=255
+                        ),
+                        cv.Optional(
+                            CONF_RETENTION
+                        ): cv.positive_time_period_milliseconds,
+                        cv.Optional(CONF_AGGREGATE): AGGREGATE_SCHEMA,
+                    }
+                )
+            ),
+            cv.Length(min=1),
+        ),
+    }
 )
 
 
-async def to_code(config):
+def validate_sensor_or_group(config):
+    if isinstance(config, dict) and CONF_VALUES in config:
+        return GROUP_SCHEMA(config)
+    if isinstance(config, dict) and CONF_DERIVED in config:
+        return DERIVED_SENSOR_SCHEMA(config)
+    return SENSOR_SCHEMA(config)
+
+
+CONFIG_SCHEMA = validate_sensor_or_group
+
+
+FINAL_VALIDATE_SCHEMA = final_validate_sensor_meter_address
+
+
+async def register_with_component(var, config):
     component = await cg.get_variable(config[CONF_ENERGOMERA_IEC_ID])
+    cg.add(var.set_request(config[CONF_REQUEST]))
+    if CONF_ADDRESS in config:
+        cg.add(component.register_sensor(var, config[CONF_ADDRESS]))
+    else:
+        cg.add(component.register_sensor(var))
+
+
+async def new_value_sensor(config):
     var = await sensor.new_sensor(config)
+    if CONF_RETENTION in config:
+        cg.add(var.set_retention_ms(config[CONF_RETENTION]))
+    if aggregate := config.get(CONF_AGGREGATE):
+        await aggregate_to_code(var, config, aggregate)
+    return var
+
+
+async def to_code(config):
+    if CONF_VALUES in config:
+        group = cg.new_Pvariable(config[CONF_ID])
+        for value_config in config[CONF_VALUES]:
+            var = await new_value_sensor(value_config)
+            cg.add(var.set_index(value_config[CONF_INDEX]))
+            cg.add(var.set_sub_index(value_config[CONF_SUB_INDEX]))
+            cg.add(group.add_sensor(var))
+        await register_with_component(group, config)
+        return
+
+    var = await new_value_sensor(config)
 
-    if CONF_REQUEST in config:
-        cg.add(var.set_request(config[CONF_REQUEST]))
+    if derived := config.get(CONF_DERIVED):
+        cg.add(var.set_derived_type(DERIVED_TYPES[derived[CONF_TYPE]]))
+        cg.add(var.set_time_unit_s(TIME_UNITS[derived[CONF_TIME_UNIT]]))
+        if CONF_MAX_GAP in derived:
+            cg.add(var.set_max_gap_ms(derived[CONF_MAX_GAP]))
+        for source_id in derived[CONF_SOURCES]:
+            source = await cg.get_variable(source_id)
+            cg.add(var.add_source(source))
+        return
 
     cg.add(var.set_index(config[CONF_INDEX]))
     cg.add(var.set_sub_index(config[CONF_SUB_INDEX]))
+    await register_with_component(var, config)
+
 
-    cg.add(component.register_sensor(var))
+async def aggregate_to_code(var, config, aggregate):
+    agg = cg.new_Pvariable(aggregate[CONF_ID])
+    cg.add(agg.set_window_ms(aggregate[CONF_WINDOW]))
+    cg.add(var.set_publish_samples(aggregate[CONF_PUBLISH_SAMPLES]))
+    for key in AGGREGATE_SENSORS:
+        if sens_config := aggregate.get(key):
+            if key != CONF_COUNT:
+                for inherited in INHERITED_KEYS:
+                    if inherited in config and inherited not in sens_config:
+                        sens_config[inherited] = config[inherited]
+            sens = await sensor.new_sensor(sens_config)
+            cg.add(getattr(agg, f"set_{key}_sensor")(sens))
+    cg.add(var.set_aggregate(agg))
@@ -2,6 +2,7 @@ import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import text_sensor
 from esphome.const import (
+    CONF_ADDRESS,
     CONF_INDEX,
 )
 from . import (
@@ -12,6 +13,8 @@ from . import (
     CONF_REQUEST,
     CONF_SUB_INDEX,
     DEFAULTS_MAX_SENSOR_INDEX,
+    validate_meter_address,
+    final_validate_sensor_meter_address,
 )
 
 AUTO_LOAD = ["energomera_iec"]
@@ -33,11 +36,14 @@ CONFIG_SCHEMA = cv.All(
             cv.Optional(CONF_SUB_INDEX, default=0): cv.int_range(
                 min=0, max=255
             ),
+            cv.Optional(CONF_ADDRESS): cv.All(cv.string, validate_meter_address),
         }
     ),
     cv.has_exactly_one_key(CONF_REQUEST),
 )
 
+FINAL_VALIDATE_SCHEMA = final_validate_sensor_meter_address
+
 
 async def to_code(config):
     component = await cg.get_variable(config[CONF_ENERGOMERA_IEC_ID])
@@ -49,4 +55,7 @@ async def to_code(config):
     cg.add(var.set_index(config[CONF_INDEX]))
     cg.add(var.set_sub_index(config[CONF_SUB_INDEX]))
 
-    cg.add(component.register_sensor(var))
+    if CONF_ADDRESS in config:
+        cg.add(component.register_sensor(var, config[CONF_ADDRESS]))
+    else:
+        cg.add(component.register_sensor(var))
@@ -0,0 +1,171 @@
+// Many meters on one RS485 line, simulated time. Either one component per meter, all contending for the bus
+// through AnyObjectLocker and retrying a busy bus every BUS_LOCK_RETRY_MS, or one component with all meters as
+// its `address` list, polling them back to back under one lock. Meters are CE102M as in ce102m.yaml.
+// Results are one JSON document, to compare between commits:
+//   bench_fleet [--quick] [--out fleet.json]
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "harness.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+static const uint32_t RUN_MS = 30 * 60 * 1000;
+static const uint32_t QUICK_RUN_MS = 5 * 60 * 1000;
+static const uint32_t SIZES[] = {1, 2, 4, 8, 12, 16};
+static const uint32_t QUICK_SIZES[] = {1, 4};
+static const uint32_t UPDATE_INTERVAL_MS = 30000;
+static const uint32_t BAUD_RATE = 9600;
+
+struct FleetResult {
+  uint32_t sessions;      // meter sessions over all components
+  float target_per_hour;  // every poll on time
+  float refresh_per_hour_min;
+  float refresh_per_hour_avg;
+  float refresh_per_hour_max;
+  float requests_per_hour;  // answered per meter, drops when the session budget cuts sessions short
+  float session_ms;       // bus held per meter session, handshake included
+  uint32_t lock_waits;
+  float lock_wait_avg_ms;
+  uint32_t lock_wait_max_ms;
+  uint32_t starved;         // waits longer than update_interval
+  uint32_t starved_meters;  // refreshed less than half as often as asked
+  float bus_held;           // some component holds the bus lock
+  float bus_busy;           // somebody transmits on the wire
+  uint32_t sign_ons;
+};
+
+static FleetResult run(uint32_t meters, bool shared_component, uint32_t run_ms) {
+  host::reset();
+  SimUart uart;
+  uart.set_baud_rate(BAUD_RATE);
+  std::vector<std::unique_ptr<SimMeter>> sim_meters;
+  std::vector<std::string> addresses;
+  for (uint32_t i = 0; i < meters; i++) {
+    addresses.push_back(std::to_string(i + 1));
+    sim_meters.push_back(make_unique<SimMeter>(addresses.back(), SimMeter::CE102M, BAUD_RATE));
+    uart.add_meter(sim_meters.back().get());
+  }
+  std::vector<std::unique_ptr<TestComponent>> components;
+  SensorSet sensors;
+  // first sensor of every meter, its publishes are the refreshes of that meter
+  std::vector<energomera_iec::EnergomeraIecSensor *> refreshes;
+  for (uint32_t i = 0; i < meters; i++) {
+    if (!shared_component || components.empty()) {
+      components.push_back(make_unique<TestComponent>());
+      auto *component = components.back().get();
+      component->set_uart_parent(&uart);
+      component->set_update_interval(UPDATE_INTERVAL_MS);
+      App.register_component(component);
+    }
+    auto *component = components.back().get();
+    refreshes.push_back(sensors.add(component, "ET0PE()", 1, addresses[i].c_str()));
+    for (const auto &spec : CE102M_CONFIG) {
+      if (spec.text) {
+        sensors.add_text(component, spec.request, addresses[i].c_str());
+      } else if (strcmp(spec.request, "ET0PE()") != 0 || spec.index != 1) {
+        sensors.add(component, spec.request, spec.index, addresses[i].c_str());
+      }
+    }
+  }
+  for (const auto &sensor : sensors.all())
+    sensor->published.reserve(run_ms / UPDATE_INTERVAL_MS + 1);
+  App.setup();
+  App.run_for(run_ms);
+
+  FleetResult result{};
+  float hours = run_ms / 3600000.0f;
+  result.target_per_hour = 3600000.0f / UPDATE_INTERVAL_MS;
+  result.refresh_per_hour_min = result.target_per_hour * 2;
+  uint32_t bus_ms = 0, wait_ms = 0;
+  for (auto *sensor : refreshes) {
+    float per_hour = sensor->published.size() / hours;
+    result.refresh_per_hour_min = std::min(result.refresh_per_hour_min, per_hour);
+    result.refresh_per_hour_max = std::max(result.refresh_per_hour_max, per_hour);
+    result.refresh_per_hour_avg += per_hour / meters;
+    if (per_hour < result.target_per_hour / 2)
+      result.starved_meters++;
+  }
+  for (const auto &sim_meter : sim_meters) {
+    result.requests_per_hour += sim_meter->get_stats().requests / hours / meters;
+    result.sign_ons += sim_meter->get_stats().sign_ons;
+  }
+  for (const auto &component : components) {
+    result.sessions += component->throughput_.sessions;
+    bus_ms += component->throughput_.bus_ms;
+    result.lock_waits += component->lock_wait_.waits;
+    wait_ms += component->lock_wait_.total_ms;
+    result.lock_wait_max_ms = std::max(result.lock_wait_max_ms, component->lock_wait_.max_ms);
+    result.starved += component->lock_wait_.starved;
+  }
+  result.session_ms = result.sessions > 0 ? (float) bus_ms / result.sessions : 0;
+  result.lock_wait_avg_ms = result.lock_waits > 0 ? (float) wait_ms / result.lock_waits : 0;
+  result.bus_held = (float) bus_ms / run_ms;
+  result.bus_busy = (float) uart.get_busy_us() / (run_ms * 1000.0f);
+  return result;
+}
+
+int main(int argc, char **argv) {
+  bool quick = false;
+  const char *out_path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--quick") == 0) {
+      quick = true;
+    } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+      out_path = argv[++i];
+    } else {
+      fprintf(stderr, "usage: %s [--quick] [--out file.json]\n", argv[0]);
+      return 1;
+    }
+  }
+  std::vector<uint32_t> sizes;
+  if (quick) {
+    sizes.assign(std::begin(QUICK_SIZES), std::end(QUICK_SIZES));
+  } else {
+    sizes.assign(std::begin(SIZES), std::end(SIZES));
+  }
+  uint32_t run_ms = quick ? QUICK_RUN_MS : RUN_MS;
+
+  FILE *out = out_path != nullptr ? fopen(out_path, "w") : stdout;
+  if (out == nullptr) {
+    perror(out_path);
+    return 1;
+  }
+  fprintf(out, "{\"benchmark\":\"fleet\",\"run_s\":%u,\"update_interval_ms\":%u,\"baud_rate\":%u,\"runs\":[",
+          run_ms / 1000, UPDATE_INTERVAL_MS, BAUD_RATE);
+  bool first = true;
+  bool all_polled = true;
+  for (bool shared_component : {false, true}) {
+    for (uint32_t meters : sizes) {
+      FleetResult r = run(meters, shared_component, run_ms);
+      const char *mode = shared_component ? "addresses" : "instances";
+      fprintf(out,
+              "%s\n{\"mode\":\"%s\",\"meters\":%u,\"sessions\":%u,\"target_per_hour\":%.0f,"
+              "\"refresh_per_hour_min\":%.1f,\"refresh_per_hour_avg\":%.1f,\"refresh_per_hour_max\":%.1f,"
+              "\"requests_per_hour\":%.0f,\"session_ms\":%.0f,\"lock_waits\":%u,\"lock_wait_avg_ms\":%.0f,"
+              "\"lock_wait_max_ms\":%u,\"starved\":%u,\"starved_meters\":%u,\"bus_held\":%.3f,\"bus_busy\":%.3f,"
+              "\"sign_ons\":%u}",
+              first ? "" : ",", mode, meters, r.sessions, r.target_per_hour, r.refresh_per_hour_min,
+              r.refresh_per_hour_avg, r.refresh_per_hour_max, r.requests_per_hour, r.session_ms, r.lock_waits,
+              r.lock_wait_avg_ms, r.lock_wait_max_ms, r.starved, r.starved_meters, r.bus_held, r.bus_busy,
+              r.sign_ons);
+      if (out != stdout)
+        printf("%-9s %2u meters: refresh/h min %.0f avg %.0f of %.0f, %.0f requests/h, %.0f ms/session, "
+               "wait avg %.0f max %u ms, %u meters starved, bus held %.3f\n",
+               mode, meters, r.refresh_per_hour_min, r.refresh_per_hour_avg, r.target_per_hour, r.requests_per_hour,
+               r.session_ms, r.lock_wait_avg_ms, r.lock_wait_max_ms, r.starved_meters, r.bus_held);
+      first = false;
+      // meters left without a poll are a result here, not a failure
+      all_polled = all_polled && r.sessions > 0;
+    }
+  }
+  fprintf(out, "\n]}\n");
+  if (out != stdout)
+    fclose(out);
+  return all_polled ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+// Whole polling cycles of one component against a simulated meter, as in ce303.yaml and ce102m.yaml,
+// at 300 to 19200 baud (handshake and session alike) with and without line noise. Time is simulated: wire time
+// of every byte, meter turnaround, loop cadence. Results are one JSON document, to compare between commits:
+//   bench_session [--quick] [--out session.json]
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "harness.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+static const uint32_t RUN_MS = 10 * 60 * 1000;
+static const uint32_t QUICK_RUN_MS = 2 * 60 * 1000;
+static const uint32_t BAUD_RATES[] = {300, 600, 1200, 2400, 4800, 9600, 19200};
+static const uint32_t QUICK_BAUD_RATES[] = {9600};
+static const double NOISE = 0.002;  // one byte in 500 has a bit flipped
+
+struct BenchConfig {
+  const char *name;
+  SimMeter::Model model;
+  const std::vector<SensorSpec> *sensors;
+  uint32_t update_interval_ms;
+};
+
+struct RunResult {
+  uint32_t sessions;
+  float sessions_per_hour;
+  float session_ms;  // bus held per session
+  uint32_t requests;
+  float ms_per_request;
+  float bus_idle;   // nobody transmitting on the wire
+  float lock_idle;  // nobody holding the bus lock
+  uint32_t corrupted_bytes;
+  uint32_t crc_errors;
+  uint32_t invalid_frames;
+  uint32_t published;
+};
+
+static RunResult run(const BenchConfig &config, uint32_t baud_rate, double noise, uint32_t run_ms) {
+  host::reset();
+  SimUart uart;
+  uart.set_baud_rate(baud_rate);  // uart: baud_rate in yaml
+  if (noise > 0)
+    uart.set_noise(noise);
+  SimMeter meter("", config.model, baud_rate);
+  uart.add_meter(&meter);
+  TestComponent component;
+  component.set_uart_parent(&uart);
+  component.set_baud_rate_handshake(baud_rate);
+  component.set_baud_rate(baud_rate);
+  component.set_update_interval(config.update_interval_ms);
+  SensorSet sensors;
+  sensors.add(&component, *config.sensors);
+  App.register_component(&component);
+  App.setup();
+  App.run_for(run_ms);
+
+  RunResult result{};
+  result.sessions = component.throughput_.sessions;
+  result.sessions_per_hour = component.get_sessions_per_hour();
+  result.session_ms = result.sessions > 0 ? (float) component.throughput_.bus_ms / result.sessions : 0;
+  result.requests = component.throughput_.requests;
+  result.ms_per_request = component.get_ms_per_request();
+  result.bus_idle = 1.0f - (float) uart.get_busy_us() / (run_ms * 1000.0f);
+  result.lock_idle = component.get_bus_idle_fraction();
+  result.corrupted_bytes = uart.get_corrupted();
+  result.crc_errors = component.meters_[0].stats.crc_errors_;
+  result.invalid_frames = component.meters_[0].stats.invalid_frames_;
+  for (const auto &sensor : sensors.all())
+    result.published += sensor->published.size();
+  return result;
+}
+
+int main(int argc, char **argv) {
+  bool quick = false;
+  const char *out_path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--quick") == 0) {
+      quick = true;
+    } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+      out_path = argv[++i];
+    } else {
+      fprintf(stderr, "usage: %s [--quick] [--out file.json]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  // top baud rate character is '6' so that the meters take 19200 as well
+  SimMeter::Model ce303 = SimMeter::CE303;
+  ce303.identity = "/EKT6CE303v12";
+  SimMeter::Model ce102m = SimMeter::CE102M;
+  ce102m.identity = "/EKT6CE102Mv01";
+  const BenchConfig configs[] = {{"ce303", ce303, &CE303_CONFIG, 10000}, {"ce102m", ce102m, &CE102M_CONFIG, 30000}};
+  std::vector<uint32_t> baud_rates;
+  if (quick) {
+    baud_rates.assign(std::begin(QUICK_BAUD_RATES), std::end(QUICK_BAUD_RATES));
+  } else {
+    baud_rates.assign(std::begin(BAUD_RATES), std::end(BAUD_RATES));
+  }
+  uint32_t run_ms = quick ? QUICK_RUN_MS : RUN_MS;
+
+  FILE *out = out_path != nullptr ? fopen(out_path, "w") : stdout;
+  if (out == nullptr) {
+    perror(out_path);
+    return 1;
+  }
+  fprintf(out, "{\"benchmark\":\"session\",\"run_s\":%u,\"runs\":[", run_ms / 1000);
+  bool first = true;
+  bool all_polled = true;
+  for (const auto &config : configs) {
+    for (uint32_t baud_rate : baud_rates) {
+      for (double noise : {0.0, NOISE}) {
+        RunResult r = run(config, baud_rate, noise, run_ms);
+        fprintf(out,
+                "%s\n{\"config\":\"%s\",\"update_interval_ms\":%u,\"baud_rate\":%u,\"noise\":%g,\"sessions\":%u,"
+                "\"sessions_per_hour\":%.1f,\"session_ms\":%.0f,\"requests\":%u,\"ms_per_request\":%.1f,"
+                "\"bus_idle\":%.3f,\"lock_idle\":%.3f,\"corrupted_bytes\":%u,\"crc_errors\":%u,\"invalid_frames\":%u,"
+                "\"published\":%u}",
+                first ? "" : ",", config.name, config.update_interval_ms, baud_rate, noise, r.sessions,
+                r.sessions_per_hour, r.session_ms, r.requests, r.ms_per_request, r.bus_idle, r.lock_idle,
+                r.corrupted_bytes, r.crc_errors, r.invalid_frames, r.published);
+        if (out != stdout)
+          printf("%-7s %5u baud, noise %g: %.0f sessions/h, %.0f ms/session, %.1f ms/request, bus idle %.3f\n",
+                 config.name, baud_rate, noise, r.sessions_per_hour, r.session_ms, r.ms_per_request, r.bus_idle);
+        first = false;
+        all_polled = all_polled && r.sessions > 0;
+      }
+    }
+  }
+  fprintf(out, "\n]}\n");
+  if (out != stdout)
+    fclose(out);
+  return all_polled ? 0 : 1;
+}
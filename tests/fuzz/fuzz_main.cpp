@@ -0,0 +1,92 @@
+// Stands in for libFuzzer where there is none: each seed in the given files or directories goes through the
+// target as it is and in a fixed set of mutations, so the run is the same every time.
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+using Input = std::vector<uint8_t>;
+
+static const int MUTATIONS_PER_SEED = 2000;
+
+static Input mutate(const Input &seed, const std::vector<Input> &seeds, std::mt19937 &rng) {
+  Input input = seed;
+  int steps = 1 + rng() % 4;
+  for (int i = 0; i < steps; i++) {
+    size_t pos = input.empty() ? 0 : rng() % input.size();
+    switch (rng() % 6) {
+      case 0:  // flip a bit
+        if (!input.empty())
+          input[pos] ^= 1 << (rng() % 8);
+        break;
+      case 1:  // any byte, protocol ones more often
+        if (!input.empty()) {
+          static const uint8_t special[] = {0x01, 0x02, 0x03, 0x06, 0x15, '\r', '\n', '(', ')', '/', '!', '*', 0};
+          input[pos] = rng() % 2 ? special[rng() % sizeof(special)] : rng();
+        }
+        break;
+      case 2:  // insert
+        input.insert(input.begin() + pos, (uint8_t) rng());
+        break;
+      case 3:  // drop
+        if (!input.empty())
+          input.erase(input.begin() + pos);
+        break;
+      case 4:  // cut short
+        input.resize(pos);
+        break;
+      case 5: {  // glue part of another seed
+        const Input &other = seeds[rng() % seeds.size()];
+        size_t from = other.empty() ? 0 : rng() % other.size();
+        input.insert(input.begin() + pos, other.begin() + from, other.end());
+      } break;
+    }
+  }
+  // longer than any buffer of the component
+  if (rng() % 50 == 0)
+    input.insert(input.end(), 300 + rng() % 300, 'A');
+  return input;
+}
+
+int main(int argc, char **argv) {
+  std::vector<Input> seeds;
+  for (int i = 1; i < argc; i++) {
+    std::vector<std::filesystem::path> files;
+    if (std::filesystem::is_directory(argv[i])) {
+      for (const auto &entry : std::filesystem::directory_iterator(argv[i]))
+        files.push_back(entry.path());
+    } else {
+      files.emplace_back(argv[i]);
+    }
+    std::sort(files.begin(), files.end());
+    for (const auto &file : files) {
+      std::ifstream in(file, std::ios::binary);
+      seeds.emplace_back(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+  }
+  if (seeds.empty()) {
+    fprintf(stderr, "usage: %s <seed file or directory>...\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::mt19937 rng(1);
+  size_t runs = 0;
+  for (const auto &seed : seeds) {
+    LLVMFuzzerTestOneInput(seed.data(), seed.size());
+    runs++;
+    for (int i = 0; i < MUTATIONS_PER_SEED; i++) {
+      Input input = mutate(seed, seeds, rng);
+      LLVMFuzzerTestOneInput(input.data(), input.size());
+      runs++;
+    }
+  }
+  printf("%zu seeds, %zu inputs\n", seeds.size(), runs);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,50 @@
+// Whatever comes from the line goes through every parser: frame readers, identification, values in brackets,
+// DATE_/TIME_ slicing and the data readout. Built with libFuzzer (-DFUZZ=ON, clang) or with fuzz_main.cpp.
+#include <cstddef>
+#include <cstdint>
+
+#include "harness.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+static void read_frames(const uint8_t *data, size_t size, bool ascii) {
+  ParserBench bench;
+  auto &c = bench.component;
+  bench.uart.feed(data, size);
+  while (bench.uart.available() > 0) {
+    size_t frame_size = ascii ? c.receive_frame_ascii_() : c.receive_prog_frame_(0x02, true);
+    if (frame_size == 0)
+      break;
+    if (ascii) {
+      c.extract_meter_id_(frame_size);
+      continue;
+    }
+    char *reply = (char *) &c.buffers_.in[1];
+    c.parse_meter_date_(reply, frame_size);
+    c.parse_meter_time_(reply, frame_size);
+    energomera_iec::ValueRefsArray vals;
+    uint8_t found = c.get_values_from_brackets_(reply, vals);
+    for (uint8_t i = 0; i < found; i++)
+      c.get_nth_value_from_csv_(vals[i], 2);
+  }
+}
+
+static void read_readout(const uint8_t *data, size_t size) {
+  ParserBench bench;
+  auto &c = bench.component;
+  c.readout_state_ = {};
+  bench.uart.feed(data, size);
+  int8_t result = 0;
+  while (result == 0 && bench.uart.available() > 0)
+    result = c.receive_readout_();
+  if (result > 0)
+    c.apply_readout_();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  read_frames(data, size, true);
+  read_frames(data, size, false);
+  read_readout(data, size);
+  return 0;
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "esphome/core/application.h"
+#include "energomera_iec.h"
+#include "host.h"
+#include "sim_bus.h"
+#include "sim_meter.h"
+
+namespace esphome {
+namespace host {
+
+// Component with its insides reachable from tests
+class TestComponent : public energomera_iec::EnergomeraIecComponent {
+ public:
+  using EnergomeraIecComponent::baud_rate_;
+  using EnergomeraIecComponent::buffers_;
+  using EnergomeraIecComponent::clear_rx_buffers_;
+  using EnergomeraIecComponent::extract_meter_id_;
+  using EnergomeraIecComponent::get_nth_value_from_csv_;
+  using EnergomeraIecComponent::get_values_from_brackets_;
+  using EnergomeraIecComponent::lock_wait_;
+  using EnergomeraIecComponent::apply_readout_;
+  using EnergomeraIecComponent::meter_;
+  using EnergomeraIecComponent::meter_datetime_str_;
+  using EnergomeraIecComponent::meters_;
+  using EnergomeraIecComponent::parse_meter_date_;
+  using EnergomeraIecComponent::parse_meter_time_;
+  using EnergomeraIecComponent::receive_frame_ack_nack_;
+  using EnergomeraIecComponent::receive_frame_ascii_;
+  using EnergomeraIecComponent::receive_prog_frame_;
+  using EnergomeraIecComponent::readout_state_;
+  using EnergomeraIecComponent::receive_readout_;
+  using EnergomeraIecComponent::State;
+  using EnergomeraIecComponent::state_;
+  using EnergomeraIecComponent::throughput_;
+  using EnergomeraIecComponent::transport_;
+
+  bool is_idle() const { return this->state_ == State::IDLE; }
+  // setup() builds the transport and request frames and clears the buffers, parsers need nothing else
+  void prepare_transport() {
+    if (this->transport_ == nullptr)
+      this->transport_ = make_unique<energomera_iec::EnergomeraIecUartTransport>(this->parent_);
+    this->clear_rx_buffers_();
+  }
+};
+
+struct SensorSpec {
+  const char *request;
+  uint8_t index;
+  bool text;
+};
+
+// Sensors of one component, owned here
+class SensorSet {
+ public:
+  energomera_iec::EnergomeraIecSensor *add(energomera_iec::EnergomeraIecComponent *component, const char *request,
+                                           uint8_t index = 1, const char *meter = nullptr) {
+    auto sensor = make_unique<energomera_iec::EnergomeraIecSensor>();
+    sensor->set_request(request);
+    sensor->set_index(index);
+    sensor->set_name(std::string(request) + "#" + std::to_string(index));
+    if (meter != nullptr) {
+      component->register_sensor(sensor.get(), meter);
+    } else {
+      component->register_sensor(sensor.get());
+    }
+    this->sensors_.push_back(std::move(sensor));
+    return this->sensors_.back().get();
+  }
+  energomera_iec::EnergomeraIecTextSensor *add_text(energomera_iec::EnergomeraIecComponent *component,
+                                                    const char *request, const char *meter = nullptr) {
+    auto sensor = make_unique<energomera_iec::EnergomeraIecTextSensor>();
+    sensor->set_request(request);
+    sensor->set_name(request);
+    if (meter != nullptr) {
+      component->register_sensor(sensor.get(), meter);
+    } else {
+      component->register_sensor(sensor.get());
+    }
+    this->text_sensors_.push_back(std::move(sensor));
+    return this->text_sensors_.back().get();
+  }
+  void add(energomera_iec::EnergomeraIecComponent *component, const std::vector<SensorSpec> &config,
+           const char *meter = nullptr) {
+    for (const auto &spec : config) {
+      if (spec.text) {
+        this->add_text(component, spec.request, meter);
+      } else {
+        this->add(component, spec.request, spec.index, meter);
+      }
+    }
+  }
+  const std::vector<std::unique_ptr<energomera_iec::EnergomeraIecSensor>> &all() const { return this->sensors_; }
+  const std::vector<std::unique_ptr<energomera_iec::EnergomeraIecTextSensor>> &all_text() const {
+    return this->text_sensors_;
+  }
+
+ protected:
+  std::vector<std::unique_ptr<energomera_iec::EnergomeraIecSensor>> sensors_;
+  std::vector<std::unique_ptr<energomera_iec::EnergomeraIecTextSensor>> text_sensors_;
+};
+
+// Sensors of the example configs in the repository root
+static const std::vector<SensorSpec> CE102M_CONFIG = {
+    {"ET0PE()", 1, false}, {"ET0PE()", 2, false}, {"ET0PE()", 3, false}, {"CURRE()", 1, false},
+    {"VOLTA()", 1, false}, {"FREQU()", 1, false}, {"COS_f()", 1, false}, {"POWEP()", 1, false},
+    {"SNUMB()", 1, true},  {"TIME_()", 1, true},  {"DATE_()", 1, true},
+};
+static const std::vector<SensorSpec> CE303_CONFIG = {
+    {"ET0PE()", 1, false}, {"ET0PE()", 2, false}, {"ET0PE()", 3, false}, {"CURRE()", 1, false},
+    {"CURRE()", 2, false}, {"CURRE()", 3, false}, {"VOLTA()", 1, false}, {"VOLTA()", 2, false},
+    {"VOLTA()", 3, false}, {"POWEP()", 1, false}, {"POWPP()", 1, false}, {"POWPP()", 2, false},
+    {"POWPP()", 3, false}, {"SNUMB()", 1, true},  {"TIME_()", 1, true},  {"DATE_()", 1, true},
+};
+
+// Component on a port with nothing but the bytes fed to it, sensors as in ce303.yaml, for calling parsers directly
+struct ParserBench {
+  ParserBench() {
+    this->component.set_uart_parent(&this->uart);
+    this->component.prepare_transport();
+    this->sensors.add(&this->component, CE303_CONFIG);
+    this->component.meter_ = &this->component.meters_[0];
+  }
+  ByteUart uart;
+  TestComponent component;
+  SensorSet sensors;
+};
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,406 @@
+#include "host.h"
+
+#include "esphome/core/application.h"
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
+#include "esphome/components/api/api_server.h"
+#include "esphome/components/mqtt/mqtt_client.h"
+#include "esphome/components/socket/socket.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace esphome {
+
+namespace setup_priority {
+const float BUS = 1000.0f;
+const float DATA = 600.0f;
+const float AFTER_WIFI = 200.0f;
+const float LATE = -100.0f;
+}  // namespace setup_priority
+
+Application App;  // NOLINT
+static ESPPreferences host_preferences;
+ESPPreferences *global_preferences = &host_preferences;  // NOLINT
+namespace api {
+static APIServer host_api_server;
+APIServer *global_api_server = &host_api_server;  // NOLINT
+}  // namespace api
+namespace mqtt {
+MQTTClientComponent *global_mqtt_client = nullptr;  // NOLINT
+}  // namespace mqtt
+
+// ---- clock ----
+
+static uint64_t clock_us = 0;
+
+uint32_t millis() { return (uint32_t) (clock_us / 1000); }
+uint32_t micros() { return (uint32_t) clock_us; }
+void delay(uint32_t ms) { clock_us += (uint64_t) ms * 1000; }
+void delayMicroseconds(uint32_t us) { clock_us += us; }
+void yield() {}
+
+// ---- log ----
+
+static int log_level_from_env() {
+  const char *env = getenv("ESPHOME_HOST_LOG");
+  if (env == nullptr)
+    return ESPHOME_LOG_LEVEL_NONE;
+  static const char *const NAMES[] = {"", "E", "W", "I", "C", "D", "V", "VV"};
+  for (int i = 0; i <= ESPHOME_LOG_LEVEL_VERY_VERBOSE; i++) {
+    if (strcmp(env, NAMES[i]) == 0)
+      return i;
+  }
+  return ESPHOME_LOG_LEVEL_DEBUG;
+}
+
+static int log_level = log_level_from_env();
+
+void esp_log_printf_(int level, const char *tag, int line, const char *format, ...) {
+  // formatted even when not printed, so bad arguments show up under the sanitizers
+  char buf[512];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (level > log_level)
+    return;
+  static const char LETTERS[] = "?EWICDVV";
+  printf("[%8.3f][%c][%s:%d]: %s\n", clock_us / 1e6, LETTERS[level], tag, line, buf);
+}
+
+// ---- helpers ----
+
+std::string str_sprintf(const char *fmt, ...) {
+  std::string str;
+  va_list args;
+  va_start(args, fmt);
+  size_t length = vsnprintf(nullptr, 0, fmt, args);
+  va_end(args);
+  str.resize(length);
+  va_start(args, fmt);
+  vsnprintf(&str[0], length + 1, fmt, args);
+  va_end(args);
+  return str;
+}
+
+std::string format_hex_pretty(const uint8_t *data, size_t length) {
+  std::string ret;
+  char buf[4];
+  for (size_t i = 0; i < length; i++) {
+    snprintf(buf, sizeof(buf), i == 0 ? "%02X" : ".%02X", data[i]);
+    ret += buf;
+  }
+  if (length > 4)
+    ret += " (" + std::to_string(length) + ")";
+  return ret;
+}
+
+uint32_t fnv1_hash(const std::string &str) {
+  uint32_t hash = 2166136261UL;
+  for (char c : str) {
+    hash *= 16777619UL;
+    hash ^= c;
+  }
+  return hash;
+}
+
+uint32_t HighFrequencyLoopRequester::num_requests = 0;
+
+void HighFrequencyLoopRequester::start() {
+  if (this->started_)
+    return;
+  num_requests++;
+  this->started_ = true;
+}
+
+void HighFrequencyLoopRequester::stop() {
+  if (!this->started_)
+    return;
+  num_requests--;
+  this->started_ = false;
+}
+
+bool HighFrequencyLoopRequester::is_high_frequency() { return num_requests > 0; }
+
+// ---- scheduler ----
+
+// Like the device scheduler: every set_timeout()/set_interval() allocates an item, a named one replaces
+// the previous item of the same name and kind
+struct SchedulerItem {
+  Component *component;
+  std::string name;
+  bool interval;
+  uint32_t period_ms;
+  uint64_t next_us;
+  std::function<void()> callback;
+  bool removed;
+};
+
+static std::vector<std::unique_ptr<SchedulerItem>> scheduler_items;
+
+static bool cancel_item(Component *component, const std::string &name, bool interval) {
+  bool found = false;
+  for (auto &item : scheduler_items) {
+    if (!item->removed && item->component == component && item->interval == interval && !name.empty() &&
+        item->name == name) {
+      item->removed = true;
+      found = true;
+    }
+  }
+  return found;
+}
+
+static void add_item(Component *component, const std::string &name, bool interval, uint32_t ms,
+                     std::function<void()> &&f) {
+  cancel_item(component, name, interval);
+  if (ms == SCHEDULER_DONT_RUN)
+    return;
+  auto item = make_unique<SchedulerItem>();
+  item->component = component;
+  item->name = name;
+  item->interval = interval;
+  item->period_ms = ms;
+  item->next_us = clock_us + (uint64_t) ms * 1000;
+  item->callback = std::move(f);
+  item->removed = false;
+  scheduler_items.push_back(std::move(item));
+}
+
+static void run_scheduler() {
+  // earliest due item first, callbacks may add and cancel items
+  while (true) {
+    SchedulerItem *due = nullptr;
+    for (auto &item : scheduler_items) {
+      if (!item->removed && item->next_us <= clock_us && (due == nullptr || item->next_us < due->next_us))
+        due = item.get();
+    }
+    if (due == nullptr)
+      break;
+    if (due->interval) {
+      due->next_us = clock_us + (uint64_t) due->period_ms * 1000;
+    } else {
+      due->removed = true;
+    }
+    auto callback = due->callback;  // item may be replaced from inside
+    callback();
+  }
+  scheduler_items.erase(std::remove_if(scheduler_items.begin(), scheduler_items.end(),
+                                       [](const std::unique_ptr<SchedulerItem> &item) { return item->removed; }),
+                        scheduler_items.end());
+}
+
+Component::~Component() {
+  for (auto &item : scheduler_items) {
+    if (item->component == this)
+      item->removed = true;
+  }
+}
+
+void Component::set_timeout(const std::string &name, uint32_t timeout, std::function<void()> &&f) {
+  add_item(this, name, false, timeout, std::move(f));
+}
+void Component::set_timeout(uint32_t timeout, std::function<void()> &&f) {
+  add_item(this, "", false, timeout, std::move(f));
+}
+bool Component::cancel_timeout(const std::string &name) { return cancel_item(this, name, false); }
+void Component::set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f) {
+  add_item(this, name, true, interval, std::move(f));
+}
+void Component::set_interval(uint32_t interval, std::function<void()> &&f) {
+  add_item(this, "", true, interval, std::move(f));
+}
+bool Component::cancel_interval(const std::string &name) { return cancel_item(this, name, true); }
+
+// ---- application ----
+
+void Application::setup() {
+  std::stable_sort(this->components_.begin(), this->components_.end(), [](Component *a, Component *b) {
+    return a->get_setup_priority() > b->get_setup_priority();
+  });
+  for (auto *component : this->components_)
+    component->call_setup();
+}
+
+void Application::loop() {
+  this->loop_calls_++;
+  run_scheduler();
+  for (auto *component : this->components_) {
+    if (component->is_loop_enabled() && !component->is_failed())
+      component->loop();
+  }
+  uint64_t step_us = HighFrequencyLoopRequester::is_high_frequency() ? this->high_frequency_step_us_
+                                                                     : (uint64_t) this->loop_interval_ * 1000;
+  // sleeps until the next timer at most, straight to it when no loop() is enabled
+  bool any_loop = false;
+  for (auto *component : this->components_)
+    any_loop = any_loop || component->is_loop_enabled();
+  uint64_t timer_us = host::next_timer_us();
+  if (!any_loop && timer_us != UINT64_MAX && timer_us > clock_us)
+    step_us = timer_us - clock_us;
+  if (timer_us > clock_us && timer_us - clock_us < step_us)
+    step_us = timer_us - clock_us;
+  clock_us += std::max<uint64_t>(step_us, 1);
+}
+
+void Application::run_for(uint32_t ms) {
+  uint64_t until = clock_us + (uint64_t) ms * 1000;
+  while (clock_us < until)
+    this->loop();
+}
+
+void Application::reset() {
+  this->components_.clear();
+  this->reboots_ = 0;
+  this->loop_calls_ = 0;
+}
+
+// ---- test side ----
+
+namespace host {
+
+uint64_t now_us() { return clock_us; }
+void advance_us(uint64_t us) { clock_us += us; }
+
+uint64_t next_timer_us() {
+  uint64_t next = UINT64_MAX;
+  for (auto &item : scheduler_items) {
+    if (!item->removed)
+      next = std::min(next, item->next_us);
+  }
+  return next;
+}
+
+void reset() {
+  scheduler_items.clear();
+  api::host_api_server.connected = true;
+  App.reset();
+  host_preferences.clear();
+  clock_us = 0;
+}
+
+void set_log_level(int level) { log_level = level; }
+
+}  // namespace host
+
+// ---- sockets ----
+
+namespace socket {
+
+class BSDSocketImpl : public Socket {
+ public:
+  explicit BSDSocketImpl(int fd) : fd_(fd) {}
+  ~BSDSocketImpl() override { this->close(); }
+
+  std::unique_ptr<Socket> accept(struct sockaddr *addr, socklen_t *addrlen) override {
+    int fd = ::accept(this->fd_, addr, addrlen);
+    if (fd == -1)
+      return nullptr;
+    return make_unique<BSDSocketImpl>(fd);
+  }
+  int bind(const struct sockaddr *addr, socklen_t addrlen) override { return ::bind(this->fd_, addr, addrlen); }
+  int close() override {
+    if (this->fd_ < 0)
+      return 0;
+    int ret = ::close(this->fd_);
+    this->fd_ = -1;
+    return ret;
+  }
+  int connect(const struct sockaddr *addr, socklen_t addrlen) override {
+    return ::connect(this->fd_, addr, addrlen);
+  }
+  int shutdown(int how) override { return ::shutdown(this->fd_, how); }
+  int getpeername(struct sockaddr *addr, socklen_t *addrlen) override {
+    return ::getpeername(this->fd_, addr, addrlen);
+  }
+  std::string getpeername() override {
+    struct sockaddr_storage storage;
+    socklen_t len = sizeof(storage);
+    if (::getpeername(this->fd_, (struct sockaddr *) &storage, &len) != 0)
+      return "";
+    return format_sockaddr_(storage);
+  }
+  int getsockname(struct sockaddr *addr, socklen_t *addrlen) override {
+    return ::getsockname(this->fd_, addr, addrlen);
+  }
+  std::string getsockname() override {
+    struct sockaddr_storage storage;
+    socklen_t len = sizeof(storage);
+    if (::getsockname(this->fd_, (struct sockaddr *) &storage, &len) != 0)
+      return "";
+    return format_sockaddr_(storage);
+  }
+  int getsockopt(int level, int optname, void *optval, socklen_t *optlen) override {
+    return ::getsockopt(this->fd_, level, optname, optval, optlen);
+  }
+  int setsockopt(int level, int optname, const void *optval, socklen_t optlen) override {
+    return ::setsockopt(this->fd_, level, optname, optval, optlen);
+  }
+  int listen(int backlog) override { return ::listen(this->fd_, backlog); }
+  ssize_t read(void *buf, size_t len) override { return ::read(this->fd_, buf, len); }
+  ssize_t write(const void *buf, size_t len) override { return ::send(this->fd_, buf, len, MSG_NOSIGNAL); }
+  int setblocking(bool blocking) override {
+    int flags = fcntl(this->fd_, F_GETFL, 0);
+    flags = blocking ? flags & ~O_NONBLOCK : flags | O_NONBLOCK;
+    return fcntl(this->fd_, F_SETFL, flags);
+  }
+  int get_fd() const override { return this->fd_; }
+
+ protected:
+  static std::string format_sockaddr_(const struct sockaddr_storage &storage) {
+    char buf[INET_ADDRSTRLEN]{};
+    if (storage.ss_family != AF_INET)
+      return "";
+    inet_ntop(AF_INET, &((const struct sockaddr_in *) &storage)->sin_addr, buf, sizeof(buf));
+    return buf;
+  }
+
+  int fd_;
+};
+
+std::unique_ptr<Socket> socket(int domain, int type, int protocol) {
+  int fd = ::socket(domain, type, protocol);
+  if (fd == -1)
+    return nullptr;
+  return make_unique<BSDSocketImpl>(fd);
+}
+
+std::unique_ptr<Socket> socket_ip(int type, int protocol) { return socket(AF_INET, type, protocol); }
+
+socklen_t set_sockaddr(struct sockaddr *addr, socklen_t addrlen, const std::string &ip_address, uint16_t port) {
+  if (addrlen < sizeof(struct sockaddr_in))
+    return 0;
+  auto *server = reinterpret_cast<struct sockaddr_in *>(addr);
+  memset(server, 0, sizeof(struct sockaddr_in));
+  server->sin_family = AF_INET;
+  server->sin_port = htons(port);
+  if (inet_pton(AF_INET, ip_address.c_str(), &server->sin_addr) != 1) {
+    errno = EINVAL;
+    return 0;
+  }
+  return sizeof(struct sockaddr_in);
+}
+
+socklen_t set_sockaddr_any(struct sockaddr *addr, socklen_t addrlen, uint16_t port) {
+  if (addrlen < sizeof(struct sockaddr_in))
+    return 0;
+  auto *server = reinterpret_cast<struct sockaddr_in *>(addr);
+  memset(server, 0, sizeof(struct sockaddr_in));
+  server->sin_family = AF_INET;
+  server->sin_port = htons(port);
+  server->sin_addr.s_addr = htonl(INADDR_LOOPBACK);  // tests stay on this machine
+  return sizeof(struct sockaddr_in);
+}
+
+}  // namespace socket
+}  // namespace esphome
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+
+// Test side of the host build: the simulated clock and a clean slate between scenarios
+namespace esphome {
+namespace host {
+
+uint64_t now_us();
+void advance_us(uint64_t us);
+// earliest pending timer, UINT64_MAX if none
+uint64_t next_timer_us();
+
+// timers, components, preferences and the clock back to zero
+void reset();
+
+// ESPHOME_HOST_LOG sets it from the environment: E, W, I, C, D, V or VV, nothing printed by default
+void set_log_level(int level);
+
+// The simulated line and meters run inside one: what they allocate is not the component's
+struct SimScope {
+  SimScope() { depth++; }
+  ~SimScope() { depth--; }
+  static bool active() { return depth > 0; }
+  static inline int depth = 0;
+};
+
+}  // namespace host
+}  // namespace esphome
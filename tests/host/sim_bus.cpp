@@ -0,0 +1,90 @@
+#include "sim_bus.h"
+#include "host.h"
+
+#include <algorithm>
+
+namespace esphome {
+namespace host {
+
+void SimUart::transmit_(std::deque<WireByte> &queue, uint64_t &free_us, const uint8_t *data, size_t len,
+                        uint32_t baud_rate, uint64_t start_us) {
+  uint64_t at = std::max(start_us, free_us);
+  uint64_t per_byte = byte_us(baud_rate);
+  for (size_t i = 0; i < len; i++) {
+    at += per_byte;
+    queue.push_back({at, data[i], baud_rate});
+  }
+  this->busy_us_ += per_byte * len;
+  free_us = at;
+}
+
+void SimUart::write_array(const uint8_t *data, size_t len) {
+  SimScope scope;
+  this->advance_();
+  this->transmit_(this->to_meters_, this->host_free_us_, data, len, this->baud_rate_, now_us());
+}
+
+void SimUart::flush() {
+  if (this->host_free_us_ > now_us())
+    advance_us(this->host_free_us_ - now_us());
+}
+
+uint8_t SimUart::noise_(uint8_t value) {
+  if (this->byte_error_rate_ <= 0 || std::uniform_real_distribution<double>(0, 1)(this->rng_) >= this->byte_error_rate_)
+    return value;
+  this->corrupted_++;
+  return value ^ (1 << std::uniform_int_distribution<int>(0, 6)(this->rng_));
+}
+
+// Everything that happened on the line up to now, in time order
+void SimUart::advance_() {
+  SimScope scope;
+  uint64_t now = now_us();
+  while (!this->to_meters_.empty() && this->to_meters_.front().at_us <= now) {
+    WireByte wb = this->to_meters_.front();
+    this->to_meters_.pop_front();
+    uint8_t value = this->noise_(wb.value);
+    for (auto *meter : this->meters_) {
+      uint8_t received = meter->get_baud_rate() == wb.baud_rate ? value : 0xFF;
+      auto reply = meter->on_byte(received, wb.at_us);
+      if (reply.bytes.empty())
+        continue;
+      this->transmit_(this->to_host_, this->meters_free_us_, (const uint8_t *) reply.bytes.data(), reply.bytes.size(),
+                      reply.baud_rate, wb.at_us + reply.delay_ms * 1000ULL);
+    }
+  }
+}
+
+int SimUart::available() {
+  this->advance_();
+  uint64_t now = now_us();
+  int count = 0;
+  for (const auto &wb : this->to_host_) {
+    if (wb.at_us > now)
+      break;
+    count++;
+  }
+  return count;
+}
+
+bool SimUart::peek_byte(uint8_t *data) {
+  if (this->available() < 1)
+    return false;
+  const auto &wb = this->to_host_.front();
+  *data = wb.baud_rate == this->baud_rate_ ? wb.value : 0xFF;
+  return true;
+}
+
+bool SimUart::read_array(uint8_t *data, size_t len) {
+  if ((size_t) this->available() < len)
+    return false;
+  for (size_t i = 0; i < len; i++) {
+    WireByte wb = this->to_host_.front();
+    this->to_host_.pop_front();
+    data[i] = wb.baud_rate == this->baud_rate_ ? this->noise_(wb.value) : 0xFF;
+  }
+  return true;
+}
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "esphome/components/uart/uart.h"
+#include "sim_meter.h"
+
+namespace esphome {
+namespace host {
+
+// RS485 line with meters on it, as a UART port. Every byte takes its wire time at the baud rate of whoever
+// sends it (7E1, 10 bits), meters reply after their turnaround. A byte sent at one baud rate and received at
+// another arrives garbled, noise flips a bit in a byte now and then.
+class SimUart : public uart::UARTComponent {
+ public:
+  void add_meter(SimMeter *meter) { this->meters_.push_back(meter); }
+  void set_noise(double byte_error_rate, uint32_t seed = 1) {
+    this->byte_error_rate_ = byte_error_rate;
+    this->rng_.seed(seed);
+  }
+
+  void write_array(const uint8_t *data, size_t len) override;
+  bool peek_byte(uint8_t *data) override;
+  bool read_array(uint8_t *data, size_t len) override;
+  int available() override;
+  // returns once the last byte is out, like the hardware FIFO drain
+  void flush() override;
+
+  static uint64_t byte_us(uint32_t baud_rate) { return 10000000ULL / baud_rate; }
+
+  // wire time with anybody transmitting
+  uint64_t get_busy_us() const { return this->busy_us_; }
+  uint32_t get_corrupted() const { return this->corrupted_; }
+
+ protected:
+  struct WireByte {
+    uint64_t at_us;  // last bit is on the wire
+    uint8_t value;
+    uint32_t baud_rate;
+  };
+
+  void advance_();
+  uint8_t noise_(uint8_t value);
+  void transmit_(std::deque<WireByte> &queue, uint64_t &free_us, const uint8_t *data, size_t len, uint32_t baud_rate,
+                 uint64_t start_us);
+
+  std::vector<SimMeter *> meters_;
+  std::deque<WireByte> to_meters_;
+  std::deque<WireByte> to_host_;
+  uint64_t host_free_us_{0};
+  uint64_t meters_free_us_{0};
+  uint64_t busy_us_{0};
+  double byte_error_rate_{0};
+  uint32_t corrupted_{0};
+  std::mt19937 rng_{1};
+};
+
+// Port with the given bytes waiting in its RX buffer and no line behind it, for parser tests
+class ByteUart : public uart::UARTComponent {
+ public:
+  void feed(const uint8_t *data, size_t len) { this->rx_.insert(this->rx_.end(), data, data + len); }
+  void feed(const std::string &data) { this->feed((const uint8_t *) data.data(), data.size()); }
+
+  void write_array(const uint8_t *data, size_t len) override {}
+  bool peek_byte(uint8_t *data) override {
+    if (this->rx_.empty())
+      return false;
+    *data = this->rx_.front();
+    return true;
+  }
+  bool read_array(uint8_t *data, size_t len) override {
+    if (this->rx_.size() < len)
+      return false;
+    for (size_t i = 0; i < len; i++) {
+      data[i] = this->rx_.front();
+      this->rx_.pop_front();
+    }
+    return true;
+  }
+  int available() override { return this->rx_.size(); }
+  void flush() override {}
+
+ protected:
+  std::deque<uint8_t> rx_;
+};
+
+}  // namespace host
+}  // namespace esphome
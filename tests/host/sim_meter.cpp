@@ -0,0 +1,208 @@
+#include "sim_meter.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace esphome {
+namespace host {
+
+static constexpr char SOH = 0x01;
+static constexpr char STX = 0x02;
+static constexpr char ETX = 0x03;
+static constexpr char ACK = 0x06;
+static constexpr char NAK = 0x15;
+
+const SimMeter::Model SimMeter::CE102M{"/EKT5CE102Mv01", false, 1, 60, 3000};
+const SimMeter::Model SimMeter::CE301{"/EKT5CE301v12", false, 2, 80, 3000};
+const SimMeter::Model SimMeter::CE303{"/EKT5CE303v12", true, 2, 80, 3000};
+
+SimMeter::SimMeter(const std::string &address, const Model &model, uint32_t baud_rate)
+    : address_(address), model_(model), handshake_baud_rate_(baud_rate), baud_rate_(baud_rate) {
+  this->values_["ET0PE"] = {"15921.38", "7956.98", "7964.40"};
+  this->values_["VOLTA"] = {"229.71", "231.02", "228.40"};
+  this->values_["CURRE"] = {"1.523", "0.004", "2.210"};
+  this->values_["POWEP"] = {"0.843"};
+  this->values_["POWPP"] = {"0.349", "0.001", "0.493"};
+  this->values_["FREQU"] = {"49.98"};
+  this->values_["COS_f"] = {"0.98", "1.00", "0.97"};
+  this->values_["SNUMB"] = {"009218086000123"};
+}
+
+uint8_t SimMeter::bcc(const std::string &data, size_t from) {
+  uint8_t bcc = 0;
+  for (size_t i = from; i < data.size(); i++)
+    bcc = (bcc + (uint8_t) data[i]) & 0x7f;
+  return bcc;
+}
+
+std::string SimMeter::prog_frame(char start, const std::string &data) {
+  std::string frame(1, start);
+  frame += data;
+  frame += ETX;
+  frame += (char) bcc(frame, 1);
+  return frame;
+}
+
+void SimMeter::reset_(uint64_t at_us) {
+  this->mode_ = Mode::IDLE;
+  this->rx_.clear();
+  this->expect_bcc_ = false;
+  this->baud_rate_ = this->handshake_baud_rate_;
+}
+
+time_t SimMeter::meter_time_(uint64_t at_us) const {
+  return this->epoch_ + (time_t) (at_us / 1000000) + this->clock_offset_s_;
+}
+
+SimMeter::Reply SimMeter::on_byte(uint8_t byte, uint64_t at_us) {
+  // meter drops the session after a pause
+  if (this->mode_ != Mode::IDLE && at_us - this->last_rx_us_ > this->model_.session_timeout_ms * 1000ULL)
+    this->reset_(at_us);
+  this->last_rx_us_ = at_us;
+
+  if (this->mode_ == Mode::PROGRAMMING) {
+    if (this->expect_bcc_) {
+      this->expect_bcc_ = false;
+      std::string frame = this->rx_ + (char) byte;
+      this->rx_.clear();
+      return this->command_(frame);
+    }
+    if (this->rx_.empty() && byte != SOH)
+      return {};  // noise between frames
+    this->rx_ += (char) byte;
+    if (byte == ETX)
+      this->expect_bcc_ = true;
+    if (this->rx_.size() > 128)
+      this->rx_.clear();
+    return {};
+  }
+
+  // sign-on and acknowledgement are lines
+  if (this->mode_ == Mode::IDLE && byte == '/')
+    this->rx_.clear();
+  this->rx_ += (char) byte;
+  if (this->rx_.size() > 64)
+    this->rx_.clear();
+  if (this->rx_.size() < 2 || this->rx_.compare(this->rx_.size() - 2, 2, "\r\n") != 0)
+    return {};
+  std::string line = this->rx_;
+  this->rx_.clear();
+  return this->mode_ == Mode::IDLE ? this->sign_on_(line) : this->acknowledge_(line);
+}
+
+SimMeter::Reply SimMeter::sign_on_(const std::string &line) {
+  // "/?address!\r\n", empty address talks to any meter
+  if (line.size() < 5 || line[0] != '/' || line[1] != '?' || line[line.size() - 3] != '!')
+    return {};
+  std::string address = line.substr(2, line.size() - 5);
+  if (!address.empty() && address != this->address_)
+    return {};
+  this->stats_.sign_ons++;
+  this->mode_ = Mode::IDENTIFIED;
+  return {std::string(this->model_.identity) + "\r\n", this->baud_rate_, this->model_.turnaround_ms};
+}
+
+SimMeter::Reply SimMeter::acknowledge_(const std::string &line) {
+  // "<ACK>0Z1\r\n" programming mode, "<ACK>0Z0\r\n" data readout, Z is baud rate
+  if (line.size() != 6 || line[0] != ACK || line[1] != '0') {
+    this->reset_(0);
+    return {};
+  }
+  char top = this->model_.identity[4];
+  char z = line[2];
+  if (z < '0' || z > top) {
+    this->reset_(0);
+    return {};
+  }
+  this->baud_rate_ = 300u << (z - '0');
+  if (line[3] == '1') {
+    this->mode_ = Mode::PROGRAMMING;
+    return {prog_frame(SOH, "P0" + std::string(1, STX) + "(" + this->address_ + ")"), this->baud_rate_,
+            this->model_.turnaround_ms};
+  }
+  if (line[3] == '0' && this->readout_) {
+    this->stats_.readouts++;
+    Reply reply{this->readout_block_(), this->baud_rate_, this->model_.turnaround_ms};
+    this->reset_(0);
+    return reply;
+  }
+  this->reset_(0);
+  return {};
+}
+
+std::string SimMeter::dataset_(const std::string &name, const std::vector<std::string> &values) const {
+  std::string data;
+  for (size_t i = 0; i < values.size(); i++) {
+    if (i == 0 || this->model_.name_on_each_value)
+      data += name;
+    data += "(" + values[i] + ")\r\n";
+  }
+  return data;
+}
+
+std::string SimMeter::readout_block_() const {
+  std::string block(1, STX);
+  for (const auto &kv : this->values_)
+    block += this->dataset_(kv.first, kv.second);
+  block += "!\r\n";
+  block += ETX;
+  block += (char) (bcc(block, 1) ^ (this->readout_bcc_error_ ? 1 : 0));
+  return block;
+}
+
+SimMeter::Reply SimMeter::command_(const std::string &frame) {
+  uint32_t turnaround = this->model_.turnaround_ms;
+  // "<SOH>R1<STX>NAME(args)<ETX><BCC>"
+  if (frame.size() < 5 || bcc(frame.substr(0, frame.size() - 1), 1) != (uint8_t) frame.back()) {
+    this->stats_.bad_frames++;
+    return {std::string(1, NAK), this->baud_rate_, turnaround};
+  }
+  std::string cmd = frame.substr(1, 2);
+  if (cmd == "B0") {
+    this->reset_(0);
+    return {};
+  }
+  if (frame.size() < 6 || frame[3] != STX) {
+    this->stats_.bad_frames++;
+    return {std::string(1, NAK), this->baud_rate_, turnaround};
+  }
+  std::string body = frame.substr(4, frame.size() - 6);
+  size_t bracket = body.find('(');
+  std::string name = body.substr(0, bracket);
+  std::string args = bracket == std::string::npos ? "" : body.substr(bracket + 1, body.size() - bracket - 2);
+
+  if (cmd == "W1" && name == "CTIME") {
+    int32_t correction = atoi(args.c_str());
+    this->clock_offset_s_ += correction;
+    this->stats_.corrected_s += correction;
+    this->stats_.corrections++;
+    return {std::string(1, ACK), this->baud_rate_, turnaround};
+  }
+  if (cmd != "R1") {
+    this->stats_.bad_frames++;
+    return {std::string(1, NAK), this->baud_rate_, turnaround};
+  }
+  this->stats_.requests++;
+
+  time_t now = this->meter_time_(this->last_rx_us_);
+  struct tm tm;
+  gmtime_r(&now, &tm);
+  char buf[32];
+  std::string data;
+  if (name == "DATE_") {
+    snprintf(buf, sizeof(buf), this->model_.weekday_digits == 1 ? "%d.%02d.%02d.%02d" : "%02d.%02d.%02d.%02d",
+             tm.tm_wday, tm.tm_mday, tm.tm_mon + 1, tm.tm_year % 100);
+    data = "DATE_(" + std::string(buf) + ")\r\n";
+  } else if (name == "TIME_") {
+    snprintf(buf, sizeof(buf), "%02d:%02d:%02d", tm.tm_hour, tm.tm_min, tm.tm_sec);
+    data = "TIME_(" + std::string(buf) + ")\r\n";
+  } else {
+    auto it = this->values_.find(name);
+    data = it != this->values_.end() ? this->dataset_(name, it->second) : "(ERR12)\r\n";
+  }
+  return {prog_frame(STX, data), this->baud_rate_, turnaround};
+}
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace esphome {
+namespace host {
+
+// Energomera meter as seen on the wire: sign-on, programming mode R1/W1/B0, data readout.
+// Bytes go in one by one with the time they arrived, replies come out whole and the line puts them on the wire.
+class SimMeter {
+ public:
+  struct Model {
+    const char *identity;       // "/EKT5CE102Mv01", 5th char is the top baud rate
+    bool name_on_each_value;    // "VOLTA(1)\r\nVOLTA(2)" instead of "VOLTA(1)\r\n(2)"
+    uint8_t weekday_digits;     // DATE_(w.dd.mm.yy) or DATE_(0w.dd.mm.yy)
+    uint32_t turnaround_ms;     // from end of request to start of reply
+    uint32_t session_timeout_ms;
+  };
+  static const Model CE102M;
+  static const Model CE301;
+  static const Model CE303;
+
+  struct Reply {
+    std::string bytes;
+    uint32_t baud_rate;
+    uint32_t delay_ms;  // after the request
+  };
+
+  SimMeter(const std::string &address, const Model &model, uint32_t baud_rate = 9600);
+
+  void set_value(const std::string &name, const std::vector<std::string> &values) { this->values_[name] = values; }
+  // the meter answers ERR12 from now on, as for a request it does not know
+  void remove_value(const std::string &name) { this->values_.erase(name); }
+  // meter clock is true time plus offset, true time is epoch plus simulated time
+  void set_clock(time_t epoch, int32_t offset_s) {
+    this->epoch_ = epoch;
+    this->clock_offset_s_ = offset_s;
+  }
+  void set_readout(bool readout) { this->readout_ = readout; }
+  // readout block ends with a wrong BCC, as if a byte got lost on the way
+  void set_readout_bcc_error(bool error) { this->readout_bcc_error_ = error; }
+
+  Reply on_byte(uint8_t byte, uint64_t at_us);
+  uint32_t get_baud_rate() const { return this->baud_rate_; }
+  const std::string &get_address() const { return this->address_; }
+  const Model &get_model() const { return this->model_; }
+
+  struct Stats {
+    uint32_t sign_ons{0};
+    uint32_t requests{0};
+    uint32_t bad_frames{0};
+    uint32_t readouts{0};
+    int32_t corrected_s{0};
+    uint32_t corrections{0};
+  };
+  const Stats &get_stats() const { return this->stats_; }
+
+  static uint8_t bcc(const std::string &data, size_t from);
+  static std::string prog_frame(char start, const std::string &data);  // "<start>data<ETX><BCC>"
+
+ protected:
+  enum class Mode { IDLE, IDENTIFIED, PROGRAMMING };
+
+  Reply sign_on_(const std::string &line);
+  Reply acknowledge_(const std::string &line);
+  Reply command_(const std::string &frame);
+  std::string dataset_(const std::string &name, const std::vector<std::string> &values) const;
+  std::string readout_block_() const;
+  void reset_(uint64_t at_us);
+  time_t meter_time_(uint64_t at_us) const;
+
+  std::string address_;
+  Model model_;
+  uint32_t handshake_baud_rate_;
+  uint32_t baud_rate_;
+  Mode mode_{Mode::IDLE};
+  std::string rx_;
+  bool expect_bcc_{false};
+  uint64_t last_rx_us_{0};
+  bool readout_{true};
+  bool readout_bcc_error_{false};
+  std::map<std::string, std::vector<std::string>> values_;
+  time_t epoch_{1735689600};  // 2025-01-01 00:00:00
+  int32_t clock_offset_s_{0};
+  Stats stats_;
+};
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,15 @@
+#pragma once
+
+namespace esphome {
+namespace api {
+
+class APIServer {
+ public:
+  bool is_connected() const { return this->connected; }
+  bool connected{true};
+};
+
+extern APIServer *global_api_server;  // NOLINT
+
+}  // namespace api
+}  // namespace esphome
@@ -0,0 +1,15 @@
+#pragma once
+
+namespace esphome {
+namespace mqtt {
+
+class MQTTClientComponent {
+ public:
+  bool is_connected() { return this->connected; }
+  bool connected{false};
+};
+
+extern MQTTClientComponent *global_mqtt_client;  // NOLINT
+
+}  // namespace mqtt
+}  // namespace esphome
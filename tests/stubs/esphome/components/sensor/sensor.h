@@ -0,0 +1,48 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace sensor {
+
+// Keeps what was published, tests look at it
+class Sensor {
+ public:
+  virtual ~Sensor() = default;
+
+  void publish_state(float state) {
+    this->state = state;
+    this->has_state_ = true;
+    this->published.push_back(state);
+    for (auto &callback : this->callbacks_)
+      callback(state);
+  }
+  void add_on_state_callback(std::function<void(float)> &&callback) { this->callbacks_.push_back(std::move(callback)); }
+  bool has_state() const { return this->has_state_; }
+
+  void set_name(const std::string &name) { this->name_ = name; }
+  const std::string &get_name() const { return this->name_; }
+  std::string get_object_id() const { return this->name_; }
+  uint32_t get_object_id_hash() { return fnv1_hash(this->name_); }
+  void set_accuracy_decimals(int8_t accuracy_decimals) { this->accuracy_decimals_ = accuracy_decimals; }
+  int8_t get_accuracy_decimals() { return this->accuracy_decimals_; }
+  void set_internal(bool internal) { this->internal_ = internal; }
+  bool is_internal() const { return this->internal_; }
+
+  float state{NAN};
+  std::vector<float> published;
+
+ protected:
+  std::string name_;
+  int8_t accuracy_decimals_{2};
+  bool has_state_{false};
+  bool internal_{false};
+  std::vector<std::function<void(float)>> callbacks_;
+};
+
+}  // namespace sensor
+}  // namespace esphome
@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace text_sensor {
+
+class TextSensor {
+ public:
+  virtual ~TextSensor() = default;
+
+  void publish_state(const std::string &state) {
+    this->state = state;
+    this->published.push_back(state);
+  }
+  bool has_state() const { return !this->published.empty(); }
+
+  void set_name(const std::string &name) { this->name_ = name; }
+  const std::string &get_name() const { return this->name_; }
+  uint32_t get_object_id_hash() { return fnv1_hash(this->name_); }
+
+  std::string state;
+  std::vector<std::string> published;
+
+ protected:
+  std::string name_;
+};
+
+}  // namespace text_sensor
+}  // namespace esphome
@@ -0,0 +1,31 @@
+#pragma once
+#include "esphome/core/component.h"
+#include "esphome/core/time.h"
+
+namespace esphome {
+namespace time {
+
+// Follows the simulated clock from the epoch it is given, invalid until then
+class RealTimeClock : public PollingComponent {
+ public:
+  void set_epoch(time_t epoch) {
+    this->epoch_ = epoch;
+    this->epoch_ms_ = millis();
+  }
+  void invalidate() { this->epoch_ = 0; }
+
+  ESPTime now() { return this->utcnow(); }
+  ESPTime utcnow() {
+    if (this->epoch_ == 0)
+      return ESPTime{};
+    return ESPTime::from_epoch_utc(this->epoch_ + (millis() - this->epoch_ms_) / 1000);
+  }
+  void update() override {}
+
+ protected:
+  time_t epoch_{0};
+  uint32_t epoch_ms_{0};
+};
+
+}  // namespace time
+}  // namespace esphome
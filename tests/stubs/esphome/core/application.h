@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+
+// Main loop on simulated time: due timers, then loop() of components that have it enabled,
+// then the clock moves on by the loop interval, or by the high frequency step while one is requested
+class Application {
+ public:
+  void register_component(Component *component) { this->components_.push_back(component); }
+  void setup();
+  void loop();
+  void run_for(uint32_t ms);
+  // until the condition holds or timeout_ms passes, true if it holds
+  template<typename Fn> bool run_until(Fn &&condition, uint32_t timeout_ms) {
+    uint32_t started = millis();
+    while (!condition()) {
+      if (millis() - started >= timeout_ms)
+        return false;
+      this->loop();
+    }
+    return true;
+  }
+
+  void safe_reboot() { this->reboots_++; }
+  void feed_wdt() {}
+  uint32_t get_loop_interval() const { return this->loop_interval_; }
+  void set_loop_interval(uint32_t loop_interval) { this->loop_interval_ = loop_interval; }
+  void set_high_frequency_step_us(uint32_t step_us) { this->high_frequency_step_us_ = step_us; }
+
+  uint32_t get_reboots() const { return this->reboots_; }
+  uint32_t get_loop_calls() const { return this->loop_calls_; }
+  void reset();  // forget components, timers and counters
+
+ protected:
+  std::vector<Component *> components_;
+  uint32_t loop_interval_{16};
+  uint32_t high_frequency_step_us_{500};
+  uint32_t reboots_{0};
+  uint32_t loop_calls_{0};
+};
+
+extern Application App;  // NOLINT
+
+}  // namespace esphome
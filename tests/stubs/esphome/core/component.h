@@ -0,0 +1,72 @@
+#pragma once
+#include <functional>
+#include <string>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/optional.h"
+
+namespace esphome {
+
+namespace setup_priority {
+extern const float BUS;
+extern const float DATA;
+extern const float AFTER_WIFI;
+extern const float LATE;
+}  // namespace setup_priority
+
+const uint32_t SCHEDULER_DONT_RUN = 4294967295UL;
+
+// Timers go to the simulated scheduler in tests/host/host.cpp, loop() is called by Application::loop()
+class Component {
+ public:
+  virtual ~Component();
+
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual float get_setup_priority() const { return 0.0f; }
+  virtual void call_setup() { this->setup(); }
+
+  bool is_ready() const { return !this->failed_; }
+  bool is_failed() const { return this->failed_; }
+  void mark_failed() { this->failed_ = true; }
+
+  void enable_loop() { this->loop_enabled_ = true; }
+  void disable_loop() { this->loop_enabled_ = false; }
+  void enable_loop_soon_any_context() { this->loop_enabled_ = true; }
+  bool is_loop_enabled() const { return this->loop_enabled_; }
+
+ protected:
+  void set_timeout(const std::string &name, uint32_t timeout, std::function<void()> &&f);
+  void set_timeout(uint32_t timeout, std::function<void()> &&f);
+  bool cancel_timeout(const std::string &name);
+  void set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f);
+  void set_interval(uint32_t interval, std::function<void()> &&f);
+  bool cancel_interval(const std::string &name);
+
+  bool failed_{false};
+  bool loop_enabled_{true};
+};
+
+class PollingComponent : public Component {
+ public:
+  PollingComponent() = default;
+  explicit PollingComponent(uint32_t update_interval) : update_interval_(update_interval) {}
+
+  virtual void update() = 0;
+  void call_setup() override {
+    this->setup();
+    this->start_poller();
+  }
+
+  virtual void set_update_interval(uint32_t update_interval) { this->update_interval_ = update_interval; }
+  virtual uint32_t get_update_interval() const { return this->update_interval_; }
+
+  void start_poller() { this->set_interval("update", this->get_update_interval(), [this]() { this->update(); }); }
+  void stop_poller() { this->cancel_interval("update"); }
+
+ protected:
+  uint32_t update_interval_{0};
+};
+
+}  // namespace esphome
@@ -0,0 +1,2 @@
+#pragma once
+// Host build of the component, USE_* flags come from tests/CMakeLists.txt
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Time is simulated on the host, see tests/host/sim_clock.h
+namespace esphome {
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+class GPIOPin {
+ public:
+  virtual ~GPIOPin() = default;
+  virtual void setup() {}
+  virtual void digital_write(bool value) { this->state_ = value; }
+  virtual bool digital_read() { return this->state_; }
+  virtual std::string dump_summary() const { return "sim pin"; }
+
+ protected:
+  bool state_{false};
+};
+
+}  // namespace esphome
@@ -0,0 +1,59 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/optional.h"
+
+namespace esphome {
+
+using std::make_unique;
+
+// single threaded host, nothing to wait for
+class Mutex {
+ public:
+  void lock() { this->locked_ = true; }
+  bool try_lock() {
+    if (this->locked_)
+      return false;
+    this->locked_ = true;
+    return true;
+  }
+  void unlock() { this->locked_ = false; }
+
+ private:
+  bool locked_{false};
+};
+
+class LockGuard {
+ public:
+  explicit LockGuard(Mutex &mutex) : mutex_(mutex) { mutex_.lock(); }
+  ~LockGuard() { mutex_.unlock(); }
+
+ private:
+  Mutex &mutex_;
+};
+
+std::string str_sprintf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+std::string format_hex_pretty(const uint8_t *data, size_t length);
+uint32_t fnv1_hash(const std::string &str);
+
+// Application::loop() steps the clock finely while any of these is started
+class HighFrequencyLoopRequester {
+ public:
+  void start();
+  void stop();
+  static bool is_high_frequency();
+
+ protected:
+  bool started_{false};
+  static uint32_t num_requests;
+};
+
+template<typename T> T clamp(T value, T min, T max) { return value < min ? min : (value > max ? max : value); }
+
+}  // namespace esphome
@@ -0,0 +1,6 @@
+#pragma once
+#include <optional>
+
+namespace esphome {
+template<typename T> using optional = std::optional<T>;
+}  // namespace esphome
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace esphome {
+
+// Kept in memory for the life of the process, so a test can "reboot" by building a new component
+class ESPPreferenceObject {
+ public:
+  ESPPreferenceObject() = default;
+  ESPPreferenceObject(std::vector<uint8_t> *data, size_t size) : data_(data), size_(size) {}
+
+  template<typename T> bool save(const T *src) {
+    if (this->data_ == nullptr || sizeof(T) != this->size_)
+      return false;
+    this->data_->assign((const uint8_t *) src, (const uint8_t *) src + sizeof(T));
+    return true;
+  }
+  template<typename T> bool load(T *dest) {
+    if (this->data_ == nullptr || sizeof(T) != this->size_ || this->data_->size() != sizeof(T))
+      return false;
+    memcpy(dest, this->data_->data(), sizeof(T));
+    return true;
+  }
+
+ protected:
+  std::vector<uint8_t> *data_{nullptr};
+  size_t size_{0};
+};
+
+class ESPPreferences {
+ public:
+  template<typename T> ESPPreferenceObject make_preference(uint32_t type, bool in_flash = false) {
+    return {&this->store_[type], sizeof(T)};
+  }
+  template<typename T> ESPPreferenceObject make_preference(uint32_t type, bool in_flash, uint32_t version) {
+    return this->make_preference<T>(type, in_flash);
+  }
+  bool sync() { return true; }
+  void clear() { this->store_.clear(); }
+  size_t size() const { return this->store_.size(); }
+
+ protected:
+  std::map<uint32_t, std::vector<uint8_t>> store_;
+};
+
+extern ESPPreferences *global_preferences;  // NOLINT
+
+}  // namespace esphome
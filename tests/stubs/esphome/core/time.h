@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+
+namespace esphome {
+
+// Local time is UTC on the host
+struct ESPTime {
+  uint8_t second;
+  uint8_t minute;
+  uint8_t hour;
+  uint8_t day_of_week;   // 1 = Sunday
+  uint8_t day_of_month;  // 1..31
+  uint16_t day_of_year;  // 1..366
+  uint8_t month;         // 1..12
+  uint16_t year;
+  bool is_dst;
+  time_t timestamp;
+
+  bool is_valid() const { return this->year >= 2019 && this->fields_in_range(); }
+  bool fields_in_range() const {
+    return this->second < 61 && this->minute < 60 && this->hour < 24 && this->day_of_week >= 1 &&
+           this->day_of_week <= 7 && this->day_of_month >= 1 && this->day_of_month <= 31 && this->month >= 1 &&
+           this->month <= 12;
+  }
+
+  static ESPTime from_c_tm(struct tm *c_tm, time_t c_time) {
+    ESPTime res{};
+    res.second = c_tm->tm_sec;
+    res.minute = c_tm->tm_min;
+    res.hour = c_tm->tm_hour;
+    res.day_of_week = c_tm->tm_wday + 1;
+    res.day_of_month = c_tm->tm_mday;
+    res.day_of_year = c_tm->tm_yday + 1;
+    res.month = c_tm->tm_mon + 1;
+    res.year = c_tm->tm_year + 1900;
+    res.is_dst = false;
+    res.timestamp = c_time;
+    return res;
+  }
+  static ESPTime from_epoch_local(time_t epoch) {
+    struct tm c_tm;
+    gmtime_r(&epoch, &c_tm);
+    return from_c_tm(&c_tm, epoch);
+  }
+  static ESPTime from_epoch_utc(time_t epoch) { return from_epoch_local(epoch); }
+
+  void recalc_timestamp_utc(bool use_day_of_year = true) {
+    struct tm c_tm {};
+    c_tm.tm_sec = this->second;
+    c_tm.tm_min = this->minute;
+    c_tm.tm_hour = this->hour;
+    c_tm.tm_mday = this->day_of_month;
+    c_tm.tm_mon = this->month - 1;
+    c_tm.tm_year = this->year - 1900;
+    this->timestamp = timegm(&c_tm);
+  }
+  void recalc_timestamp_local() { this->recalc_timestamp_utc(false); }
+};
+
+}  // namespace esphome
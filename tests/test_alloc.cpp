@@ -0,0 +1,110 @@
+// Steady polling must not allocate: heap on the device fragments over weeks of uptime
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "esphome/components/time/real_time_clock.h"
+#include "harness.h"
+
+static std::atomic<bool> counting{false};
+static std::atomic<uint32_t> allocations{0};
+
+void *operator new(size_t size) {
+  if (counting && !esphome::host::SimScope::active())
+    allocations++;
+  void *p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr)
+    throw std::bad_alloc();
+  return p;
+}
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return operator new(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void *operator new[](size_t size) { return operator new(size); }
+void *operator new[](size_t size, const std::nothrow_t &tag) noexcept { return operator new(size, tag); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete[](void *p, size_t) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+
+using namespace esphome;
+using namespace esphome::host;
+
+class AllocTest : public ::testing::Test {
+ protected:
+  void SetUp() override { host::reset(); }
+
+  // counts allocations over the given number of polls of the component, after the first ones settled
+  static uint32_t count_over_polls(TestComponent &component, uint32_t polls, uint32_t timeout_ms) {
+    uint32_t settled = component.throughput_.sessions + 2;
+    EXPECT_TRUE(App.run_until([&]() { return component.throughput_.sessions >= settled && component.is_idle(); },
+                              timeout_ms));
+    allocations = 0;
+    counting = true;
+    uint32_t until = component.throughput_.sessions + polls;
+    bool done = App.run_until([&]() { return component.throughput_.sessions >= until && component.is_idle(); },
+                              timeout_ms * polls);
+    counting = false;
+    EXPECT_TRUE(done);
+    return allocations;
+  }
+};
+
+static void reserve(const SensorSet &sensors) {
+  for (const auto &sensor : sensors.all())
+    sensor->published.reserve(1000);
+}
+
+TEST_F(AllocTest, StaggeredPollsDoNotAllocate) {
+  SimUart uart;
+  SimMeter meter1("1", SimMeter::CE102M);
+  SimMeter meter2("2", SimMeter::CE102M);
+  uart.add_meter(&meter1);
+  uart.add_meter(&meter2);
+
+  TestComponent first, second;
+  SensorSet sensors;
+  for (auto *component : {&first, &second}) {
+    component->set_uart_parent(&uart);
+    component->set_update_interval(20000);
+    App.register_component(component);
+  }
+  sensors.add(&first, "ET0PE()", 1, "1");
+  sensors.add(&first, "VOLTA()", 1, "1");
+  sensors.add(&second, "ET0PE()", 1, "2");
+  sensors.add(&second, "VOLTA()", 1, "2");
+  reserve(sensors);
+  App.setup();
+
+  EXPECT_EQ(count_over_polls(second, 5, 60000), 0u);
+}
+
+TEST_F(AllocTest, ClockAlignedPollsDoNotAllocate) {
+  SimUart uart;
+  SimMeter meter("", SimMeter::CE303);
+  uart.add_meter(&meter);
+  time::RealTimeClock rtc;
+  rtc.set_epoch(1700000000);
+
+  TestComponent component;
+  component.set_uart_parent(&uart);
+  component.set_update_interval(15000);
+  component.set_time_source(&rtc);
+  component.set_align_to_clock(true);
+  SensorSet sensors;
+  sensors.add(&component, "ET0PE()");
+  sensors.add(&component, "VOLTA()", 2);
+  reserve(sensors);
+  App.register_component(&component);
+  App.setup();
+
+  EXPECT_EQ(count_over_polls(component, 5, 60000), 0u);
+}
@@ -0,0 +1,143 @@
+// TCP bridge: a local socket client talks to the simulated meters through the component
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+
+#include "harness.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+// a port free right now, for the bridge to listen on
+static uint16_t free_port() {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ::bind(fd, (struct sockaddr *) &addr, sizeof(addr));
+  socklen_t len = sizeof(addr);
+  ::getsockname(fd, (struct sockaddr *) &addr, &len);
+  ::close(fd);
+  return ntohs(addr.sin_port);
+}
+
+// Vendor tool on the other end of the bridge
+class BridgeClient {
+ public:
+  explicit BridgeClient(uint16_t port) {
+    this->fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    this->connected_ = ::connect(this->fd_, (struct sockaddr *) &addr, sizeof(addr)) == 0;
+    fcntl(this->fd_, F_SETFL, O_NONBLOCK);
+    // simulated seconds pass in real microseconds, small writes must not wait for an ACK
+    int enable = 1;
+    ::setsockopt(this->fd_, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+  }
+  ~BridgeClient() { ::close(this->fd_); }
+
+  bool is_connected() const { return this->connected_; }
+  void send(const std::string &data) { ::send(this->fd_, data.data(), data.size(), MSG_NOSIGNAL); }
+  // everything received so far
+  const std::string &receive() {
+    char buf[128];
+    ssize_t len;
+    while ((len = ::read(this->fd_, buf, sizeof(buf))) > 0)
+      this->received_.append(buf, len);
+    return this->received_;
+  }
+
+ protected:
+  int fd_;
+  bool connected_{false};
+  std::string received_;
+};
+
+class BridgeTest : public ::testing::Test {
+ protected:
+  SimUart uart_;
+  uint16_t port_{free_port()};
+
+  void SetUp() override { host::reset(); }
+  void set_up(TestComponent &component, uint32_t idle_timeout_ms, uint32_t max_slot_ms) {
+    component.set_bridge(this->port_, idle_timeout_ms, max_slot_ms);
+    component.set_uart_parent(&this->uart_);
+    component.set_update_interval(10000);
+    App.register_component(&component);
+  }
+};
+
+TEST_F(BridgeTest, ClientGetsBusBetweenPolls) {
+  SimMeter meter("", SimMeter::CE303);
+  this->uart_.add_meter(&meter);
+  TestComponent component;
+  SensorSet sensors;
+  this->set_up(component, 300, 5000);
+  sensors.add(&component, "VOLTA()");
+  App.setup();
+  ASSERT_TRUE(App.run_until([&]() { return component.throughput_.sessions == 1 && component.is_idle(); }, 60000));
+  App.run_for(200);
+  // nothing to do until the next poll, the listener is checked from a timer
+  EXPECT_FALSE(component.is_loop_enabled());
+
+  BridgeClient client(this->port_);
+  ASSERT_TRUE(client.is_connected());
+  client.send("/?!\r\n");
+  ASSERT_TRUE(App.run_until([&]() { return client.receive() == "/EKT5CE303v12\r\n"; }, 2000));
+  EXPECT_EQ(meter.get_stats().sign_ons, 2u);
+  EXPECT_EQ(component.state_, TestComponent::State::BRIDGE);
+
+  // silence gives the bus back, polling goes on
+  ASSERT_TRUE(App.run_until([&]() { return component.is_idle() && !component.is_loop_enabled(); }, 2000));
+  ASSERT_TRUE(App.run_until([&]() { return component.throughput_.sessions == 2; }, 20000));
+  EXPECT_EQ(meter.get_stats().sign_ons, 3u);
+}
+
+TEST_F(BridgeTest, SlotEndsForOtherHubOnBus) {
+  SimMeter first_meter("1", SimMeter::CE303);
+  SimMeter second_meter("2", SimMeter::CE303);
+  this->uart_.add_meter(&first_meter);
+  this->uart_.add_meter(&second_meter);
+  TestComponent bridged, other;
+  SensorSet sensors;
+  this->set_up(bridged, 1000, 2000);
+  other.set_uart_parent(&this->uart_);
+  other.set_update_interval(10000);
+  App.register_component(&other);
+  sensors.add(&bridged, "VOLTA()", 1, "1");
+  sensors.add(&other, "VOLTA()", 1, "2");
+  App.setup();
+  ASSERT_TRUE(App.run_until([&]() { return bridged.throughput_.sessions == 1 && bridged.is_idle(); }, 60000));
+  ASSERT_EQ(second_meter.get_stats().sign_ons, 0u);
+
+  // the client never pauses long enough for the idle timeout
+  BridgeClient client(this->port_);
+  ASSERT_TRUE(client.is_connected());
+  uint32_t sent_ms = millis() - 1000;
+  auto keep_talking = [&]() {
+    if (millis() - sent_ms >= 200) {
+      client.send("/?1!\r\n");
+      sent_ms = millis();
+    }
+  };
+  ASSERT_TRUE(App.run_until(
+      [&]() {
+        keep_talking();
+        return bridged.state_ == TestComponent::State::BRIDGE;
+      },
+      2000));
+  ASSERT_TRUE(App.run_until(
+      [&]() {
+        keep_talking();
+        return other.throughput_.sessions == 1;
+      },
+      20000));
+  // other hub polls 5 s after the first one and waits for max_slot at most, plus one lock retry
+  EXPECT_LT(other.lock_wait_.max_ms, 2000u + 1000u + 100u);
+  EXPECT_GT(first_meter.get_stats().sign_ons, 2u);
+}
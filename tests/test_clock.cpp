@@ -0,0 +1,86 @@
+// Meter clock checks and corrections with auto_time_sync
+#include <gtest/gtest.h>
+
+#include "esphome/components/time/real_time_clock.h"
+#include "harness.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+// 2024-12-31 23:57:00
+static const time_t BEFORE_MIDNIGHT = 1735689600 - 180;
+
+class ClockTest : public ::testing::Test {
+ protected:
+  SimUart uart_;
+  SimMeter meter_{"", SimMeter::CE303};
+  time::RealTimeClock rtc_;
+
+  void SetUp() override {
+    host::reset();
+    this->uart_.add_meter(&this->meter_);
+  }
+  void set_up(TestComponent &component, SensorSet &sensors, SimUart *uart = nullptr) {
+    component.set_uart_parent(uart != nullptr ? uart : &this->uart_);
+    component.set_update_interval(60000);
+    component.set_time_source(&this->rtc_);
+    component.set_auto_time_sync(true);
+    component.set_restore_value(true);
+    sensors.add(&component, "VOLTA()");
+    App.register_component(&component);
+    App.setup();
+  }
+};
+
+TEST_F(ClockTest, NoCorrectionNearMidnight) {
+  this->rtc_.set_epoch(BEFORE_MIDNIGHT);
+  this->meter_.set_clock(BEFORE_MIDNIGHT, 20);
+  TestComponent component;
+  SensorSet sensors;
+  this->set_up(component, sensors);
+
+  ASSERT_TRUE(App.run_until([&]() { return this->meter_.get_stats().corrections > 0; }, 3600000));
+  // first session after 00:05 of the meter clock, which is 20 s ahead
+  EXPECT_GE(millis() / 1000 + 20, 180u + 300u);
+  EXPECT_LT(millis() / 1000, 180u + 300u + 60u);
+  EXPECT_EQ(this->meter_.get_stats().corrected_s, -20);
+}
+
+TEST_F(ClockTest, ClockModelSurvivesReboot) {
+  this->rtc_.set_epoch(BEFORE_MIDNIGHT + 3600);
+  this->meter_.set_clock(BEFORE_MIDNIGHT + 3600, 5);
+  {
+    TestComponent component;
+    SensorSet sensors;
+    this->set_up(component, sensors);
+    ASSERT_TRUE(App.run_until([&]() { return component.throughput_.sessions == 1; }, 60000));
+    EXPECT_EQ(this->meter_.get_stats().corrections, 1u);
+  }
+  App.reset();
+
+  TestComponent component;
+  SensorSet sensors;
+  this->set_up(component, sensors);
+  ASSERT_TRUE(App.run_until([&]() { return component.throughput_.sessions == 3; }, 600000));
+  // the clock was checked and set right before the reboot, nothing is due yet
+  EXPECT_EQ(this->meter_.get_stats().corrections, 1u);
+  EXPECT_NE(component.meters_[0].clock.checked_ts, 0u);
+  EXPECT_EQ(component.meters_[0].clock.corrected_s, 5u);
+}
+
+TEST_F(ClockTest, SinglePhaseMeterDate) {
+  // DATE_(w.dd.mm.yy), one digit shorter than on CE303
+  SimUart uart;
+  SimMeter meter("", SimMeter::CE102M);
+  uart.add_meter(&meter);
+  this->rtc_.set_epoch(BEFORE_MIDNIGHT + 3600);
+  meter.set_clock(BEFORE_MIDNIGHT + 3600, -12);
+  TestComponent component;
+  SensorSet sensors;
+  this->set_up(component, sensors, &uart);
+
+  ASSERT_TRUE(App.run_until([&]() { return component.throughput_.sessions == 1; }, 60000));
+  EXPECT_EQ(std::string(component.meter_datetime_str_, 11), "2025-01-01 ");
+  EXPECT_EQ(meter.get_stats().corrections, 1u);
+  EXPECT_EQ(meter.get_stats().corrected_s, 12);
+}
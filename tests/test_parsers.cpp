@@ -0,0 +1,163 @@
+// Frame readers and parsers called directly on bytes, without a session around them
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "harness.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+static const char STX = 0x02;
+static const char ETX = 0x03;
+static const char ACK = 0x06;
+
+class ParserTest : public ::testing::Test {
+ protected:
+  void SetUp() override { host::reset(); }
+
+  ParserBench bench_;
+  TestComponent &component_{bench_.component};
+
+  // feeds the frame and reads it back the way the session would
+  size_t receive_ascii(const std::string &bytes) {
+    this->bench_.uart.feed(bytes);
+    return this->component_.receive_frame_ascii_();
+  }
+  size_t receive_prog(const std::string &bytes) {
+    this->bench_.uart.feed(bytes);
+    return this->component_.receive_prog_frame_(STX, true);
+  }
+  const char *reply() const { return (const char *) &this->component_.buffers_.in[1]; }
+  int8_t receive_readout(const std::string &bytes) {
+    this->component_.readout_state_ = {};
+    this->bench_.uart.feed(bytes);
+    return this->component_.receive_readout_();
+  }
+  energomera_iec::EnergomeraIecSensor *sensor(const char *name) const {
+    for (const auto &sensor : this->bench_.sensors.all())
+      if (sensor->get_name() == name)
+        return sensor.get();
+    return nullptr;
+  }
+};
+
+TEST_F(ParserTest, MeterIdentification) {
+  size_t size = this->receive_ascii("/EKT5CE102Mv01\r\n");
+  ASSERT_EQ(size, 16u);
+  const char *id = this->component_.extract_meter_id_(size);
+  ASSERT_NE(id, nullptr);
+  EXPECT_STREQ(id, "/EKT5CE102Mv01");
+}
+
+TEST_F(ParserTest, MeterIdentificationAfterNoise) {
+  size_t size = this->receive_ascii(std::string("\x7f/?\xff", 4) + "/EKT5CE303v12\r\n");
+  const char *id = this->component_.extract_meter_id_(size);
+  ASSERT_NE(id, nullptr);
+  EXPECT_STREQ(id, "/EKT5CE303v12");
+}
+
+TEST_F(ParserTest, GarbageIsNotIdentification) {
+  // no '/' at all: the search must stop at the first byte of the buffer
+  EXPECT_EQ(this->component_.extract_meter_id_(this->receive_ascii("abcdefg\r\n")), nullptr);
+  EXPECT_EQ(this->component_.extract_meter_id_(this->receive_ascii("xx/ABC\r\n")), nullptr);
+  EXPECT_EQ(this->component_.extract_meter_id_(this->receive_ascii("/A\r\n")), nullptr);
+}
+
+TEST_F(ParserTest, ValuesFromBrackets) {
+  char line[] = "VOLTA(229.71)VOLTA(231.02)(228.40)";
+  energomera_iec::ValueRefsArray vals;
+  ASSERT_EQ(this->component_.get_values_from_brackets_(line, vals), 3);
+  EXPECT_STREQ(line, "VOLTA");
+  EXPECT_STREQ(vals[0], "229.71");
+  EXPECT_STREQ(vals[1], "231.02");
+  EXPECT_STREQ(vals[2], "228.40");
+  EXPECT_STREQ(vals[3], "");
+
+  char no_brackets[] = "ERR12";
+  EXPECT_EQ(this->component_.get_values_from_brackets_(no_brackets, vals), 0);
+  char unclosed[] = "VOLTA(229.71";
+  EXPECT_EQ(this->component_.get_values_from_brackets_(unclosed, vals), 0);
+
+  std::string many = "GRAPE";
+  for (int i = 0; i < 20; i++)
+    many += "(" + std::to_string(i) + ")";
+  ASSERT_EQ(this->component_.get_values_from_brackets_(&many[0], vals), energomera_iec::VAL_NUM);
+  EXPECT_STREQ(vals[energomera_iec::VAL_NUM - 1], std::to_string(energomera_iec::VAL_NUM - 1).c_str());
+}
+
+TEST_F(ParserTest, ValueFromCsv) {
+  char line[] = "20.08.24,0.45991";
+  EXPECT_STREQ(this->component_.get_nth_value_from_csv_(line, 2), "0.45991");
+  char short_line[] = "0.45991";
+  EXPECT_EQ(this->component_.get_nth_value_from_csv_(short_line, 3), nullptr);
+}
+
+TEST_F(ParserTest, ProgFrameAndAck) {
+  EXPECT_EQ(this->receive_prog(std::string(1, ACK)), 1u);
+  EXPECT_EQ(this->component_.buffers_.in[0], ACK);
+
+  std::string frame = SimMeter::prog_frame(STX, "VOLTA(229.71)\r\n");
+  EXPECT_EQ(this->receive_prog(frame), frame.size());
+  EXPECT_STREQ(this->reply(), frame.substr(1, frame.size() - 1).c_str());
+}
+
+TEST_F(ParserTest, FrameOnlyWhenComplete) {
+  std::string frame = SimMeter::prog_frame(STX, "VOLTA(229.71)\r\n");
+  EXPECT_EQ(this->receive_prog(frame.substr(0, 8)), 0u);
+  EXPECT_EQ(this->receive_prog(frame.substr(8)), frame.size());
+}
+
+TEST_F(ParserTest, MeterDateAndTime) {
+  std::string date = SimMeter::prog_frame(STX, "DATE_(05.30.05.25)\r\n");
+  ASSERT_EQ(this->receive_prog(date), 23u);
+  ASSERT_TRUE(this->component_.parse_meter_date_(this->reply(), 23));
+  std::string time = SimMeter::prog_frame(STX, "TIME_(23:40:10)\r\n");
+  ASSERT_EQ(this->receive_prog(time), 20u);
+  ASSERT_TRUE(this->component_.parse_meter_time_(this->reply(), 20));
+  EXPECT_STREQ(this->component_.meter_datetime_str_, "2025-05-30 23:40:10");
+
+  EXPECT_FALSE(this->component_.parse_meter_date_("TIME_(23:40:10)\r\n", 23));
+  EXPECT_FALSE(this->component_.parse_meter_time_("TIME_(23:40:1)\r\n", 19));
+}
+
+TEST_F(ParserTest, MeterDateOfEitherWeekdayWidth) {
+  std::string date = SimMeter::prog_frame(STX, "DATE_(5.30.05.25)\r\n");
+  ASSERT_EQ(this->receive_prog(date), 22u);
+  this->component_.meter_->profile = energomera_iec::find_meter_profile("CE102M");
+  ASSERT_TRUE(this->component_.parse_meter_date_(this->reply(), 22));
+  EXPECT_STREQ(this->component_.meter_datetime_str_, "2025-05-30 ");
+
+  // other firmware, other weekday width: the profile is only a hint
+  this->component_.meter_->profile = energomera_iec::find_meter_profile("CE303");
+  ASSERT_TRUE(this->component_.parse_meter_date_(this->reply(), 22));
+  EXPECT_STREQ(this->component_.meter_datetime_str_, "2025-05-30 ");
+  date = SimMeter::prog_frame(STX, "DATE_(005.30.05.25)\r\n");
+  ASSERT_EQ(this->receive_prog(date), 24u);
+  EXPECT_FALSE(this->component_.parse_meter_date_(this->reply(), 24));
+}
+
+TEST_F(ParserTest, ReadoutAppliedAfterBcc) {
+  std::string block(1, STX);
+  block += "ET0PE(15921.38*kWh)\r\nET0PE(7956.98*kWh)\r\nET0PE(7964.40*kWh)\r\n";
+  block += "VOLTA(229.71*V)\r\nVOLTA(231.02*V)\r\nVOLTA(228.40*V)\r\nFREQU(49.98)\r\n!\r\n";
+  block += ETX;
+  block += (char) SimMeter::bcc(block, 1);
+
+  ASSERT_EQ(this->receive_readout(block), 1);
+  EXPECT_EQ(this->component_.readout_state_.datasets, 3u);
+  this->component_.apply_readout_();
+  EXPECT_FLOAT_EQ(this->sensor("ET0PE()#2")->get_value(), 7956.98f);
+  EXPECT_FLOAT_EQ(this->sensor("VOLTA()#3")->get_value(), 228.40f);
+}
+
+TEST_F(ParserTest, ReadoutWithBadBcc) {
+  std::string block(1, STX);
+  block += "VOLTA(229.71)\r\n!\r\n";
+  block += ETX;
+  block += (char) (SimMeter::bcc(block, 1) ^ 1);
+
+  // values stay staged, readout_finished_() drops them
+  EXPECT_EQ(this->receive_readout(block), -1);
+  EXPECT_FALSE(this->sensor("VOLTA()#1")->has_value());
+}
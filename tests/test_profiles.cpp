@@ -0,0 +1,52 @@
+// Meter profiles of the component and what the config validation in __init__.py knows about them
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+
+#include "energomera_iec_profiles.h"
+
+using namespace esphome::energomera_iec;
+
+// "MODEL_DELAYS_MS = {\n    "CE102M": 150,\n ...}" as model -> delay
+static std::map<std::string, int> python_model_delays() {
+  std::ifstream in(COMPONENT_DIR "/__init__.py");
+  std::stringstream text;
+  text << in.rdbuf();
+  std::string source = text.str();
+  std::map<std::string, int> delays;
+  size_t start = source.find("MODEL_DELAYS_MS = {");
+  if (start == std::string::npos)
+    return delays;
+  std::string dict = source.substr(start, source.find('}', start) - start);
+  std::regex entry("\"(\\w+)\":\\s*(\\d+)");
+  for (std::sregex_iterator it(dict.begin(), dict.end(), entry), end; it != end; ++it)
+    delays[(*it)[1]] = std::stoi((*it)[2]);
+  return delays;
+}
+
+TEST(ProfileTest, ConfigValidationHasSameModels) {
+  auto delays = python_model_delays();
+  ASSERT_EQ(delays.size(), sizeof(METER_PROFILES) / sizeof(METER_PROFILES[0]));
+  for (const auto &profile : METER_PROFILES) {
+    ASSERT_EQ(delays.count(profile.model), 1u) << profile.model;
+    EXPECT_EQ(delays[profile.model], profile.delay_between_requests_ms) << profile.model;
+  }
+}
+
+TEST(ProfileTest, LongerModelNamesComeFirst) {
+  // "CE102" would take "CE102M" otherwise
+  EXPECT_STREQ(find_meter_profile("CE102Mv01")->model, "CE102M");
+  EXPECT_STREQ(find_meter_profile_by_identity("/EKT5CE102v01")->model, "CE102");
+  EXPECT_EQ(find_meter_profile("CE999"), nullptr);
+}
+
+TEST(ProfileTest, DateLength) {
+  for (const auto &profile : METER_PROFILES)
+    EXPECT_TRUE(profile.date_len == 10 || profile.date_len == 11) << profile.model;
+  EXPECT_EQ(find_meter_profile("CE102M")->date_len, 10);
+  EXPECT_EQ(find_meter_profile("CE303")->date_len, 11);
+}
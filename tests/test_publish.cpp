@@ -0,0 +1,166 @@
+// What goes out to Home Assistant and when
+#include <gtest/gtest.h>
+
+#include "esphome/components/time/real_time_clock.h"
+#include "harness.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+class PublishTest : public ::testing::Test {
+ protected:
+  SimUart uart_;
+  SimMeter meter_{"", SimMeter::CE102M};
+  TestComponent component_;
+  SensorSet sensors_;
+
+  void SetUp() override {
+    host::reset();
+    this->uart_.add_meter(&this->meter_);
+    this->component_.set_uart_parent(&this->uart_);
+    this->component_.set_update_interval(10000);
+  }
+  void start() {
+    App.register_component(&this->component_);
+    App.setup();
+  }
+};
+
+TEST_F(PublishTest, AggregatedSamplesStayOnDevice) {
+  sensor::Sensor mean;
+  energomera_iec::EnergomeraIecAggregate aggregate;
+  aggregate.set_window_ms(60000);
+  aggregate.set_mean_sensor(&mean);
+  auto *voltage = this->sensors_.add(&this->component_, "VOLTA()");
+  voltage->set_aggregate(&aggregate);
+  voltage->set_publish_samples(false);
+  this->start();
+  App.run_for(150000);
+
+  EXPECT_GE(this->component_.throughput_.sessions, 10u);
+  EXPECT_TRUE(voltage->published.empty());
+  EXPECT_GE(mean.published.size(), 2u);
+}
+
+TEST_F(PublishTest, AggregatedSamplesGoOutWhenAskedFor) {
+  sensor::Sensor mean;
+  energomera_iec::EnergomeraIecAggregate aggregate;
+  aggregate.set_window_ms(60000);
+  aggregate.set_mean_sensor(&mean);
+  auto *voltage = this->sensors_.add(&this->component_, "VOLTA()");
+  voltage->set_aggregate(&aggregate);
+  voltage->set_publish_samples(true);
+  this->start();
+  App.run_for(150000);
+
+  EXPECT_EQ(voltage->published.size(), this->component_.throughput_.sessions);
+  EXPECT_GE(mean.published.size(), 2u);
+}
+
+TEST_F(PublishTest, RestoredValueStaysUntilMeterAnswers) {
+  float before_reboot = 1.5f;
+  global_preferences->make_preference<float>(fnv1_hash("energomera_iec//POWEQ()/1/0")).save(&before_reboot);
+  auto *power = this->sensors_.add(&this->component_, "POWEQ()");
+  auto *voltage = this->sensors_.add(&this->component_, "VOLTA()");
+  this->component_.set_restore_value(true);
+  this->start();
+  ASSERT_TRUE(App.run_until([&]() { return this->component_.throughput_.sessions == 2; }, 60000));
+
+  // the meter does not know POWEQ, its value from before reboot is all there is
+  ASSERT_EQ(power->published.size(), 1u);
+  EXPECT_FLOAT_EQ(power->published[0], before_reboot);
+  EXPECT_TRUE(power->is_restored());
+  EXPECT_EQ(voltage->published.size(), 2u);
+}
+
+TEST_F(PublishTest, FirstPollAfterBootIsStaggered) {
+  SimUart uart;
+  SimMeter first_meter{"1", SimMeter::CE102M};
+  SimMeter second_meter{"2", SimMeter::CE102M};
+  uart.add_meter(&first_meter);
+  uart.add_meter(&second_meter);
+  TestComponent first, second;
+  for (auto *component : {&first, &second}) {
+    component->set_uart_parent(&uart);
+    component->set_update_interval(10000);
+    App.register_component(component);
+  }
+  this->sensors_.add(&first, "VOLTA()", 1, "1");
+  this->sensors_.add(&second, "VOLTA()", 1, "2");
+  App.setup();
+
+  ASSERT_TRUE(App.run_until([&]() { return first_meter.get_stats().sign_ons > 0; }, 60000));
+  uint32_t first_ms = millis();
+  ASSERT_TRUE(App.run_until([&]() { return second_meter.get_stats().sign_ons > 0; }, 60000));
+  // half of the update interval apart, not queued right behind the first one
+  EXPECT_GE(millis() - first_ms, 4900u);
+  EXPECT_EQ(first.lock_wait_.waits + second.lock_wait_.waits, 0u);
+}
+
+TEST_F(PublishTest, BufferedReadingsKeepTheirReadTime) {
+  time::RealTimeClock rtc;
+  rtc.set_epoch(1735689600);
+  this->component_.set_time_source(&rtc);
+  this->component_.set_buffer_size(16);
+  auto *voltage = this->sensors_.add(&this->component_, "VOLTA()");
+  std::vector<uint32_t> timestamps;
+  voltage->add_on_state_callback([&](float) { timestamps.push_back(voltage->get_timestamp()); });
+  api::global_api_server->connected = false;
+  this->start();
+  ASSERT_TRUE(App.run_until([&]() { return this->component_.throughput_.sessions == 3; }, 60000));
+  ASSERT_TRUE(voltage->published.empty());
+
+  api::global_api_server->connected = true;
+  uint32_t sent_s = rtc.now().timestamp;
+  ASSERT_TRUE(App.run_until([&]() { return voltage->published.size() >= 3; }, 5000));
+  // one poll every 10 s, each replayed with the time it was read at
+  ASSERT_GE(timestamps.size(), 3u);
+  EXPECT_LT(timestamps[0], sent_s - 15);
+  EXPECT_NEAR(timestamps[1] - timestamps[0], 10, 1);
+  EXPECT_NEAR(timestamps[2] - timestamps[1], 10, 1);
+}
+
+TEST_F(PublishTest, ValueNotReadThisCycleIsNotPublishedAgain) {
+  auto *voltage = this->sensors_.add(&this->component_, "VOLTA()");
+  auto *current = this->sensors_.add(&this->component_, "CURRE()");
+  this->start();
+  ASSERT_TRUE(App.run_until([&]() { return this->component_.throughput_.sessions == 1; }, 60000));
+  this->meter_.remove_value("CURRE");
+  ASSERT_TRUE(App.run_until([&]() { return this->component_.throughput_.sessions == 3; }, 60000));
+
+  EXPECT_EQ(voltage->published.size(), 3u);
+  EXPECT_EQ(current->published.size(), 1u);
+}
+
+TEST_F(PublishTest, SumSkipsCycleWithFailedSource) {
+  auto *voltage = this->sensors_.add(&this->component_, "VOLTA()");
+  auto *current = this->sensors_.add(&this->component_, "CURRE()");
+  energomera_iec::EnergomeraIecDerivedSensor sum;
+  sum.set_derived_type(energomera_iec::DerivedType::SUM);
+  sum.add_source(voltage);
+  sum.add_source(current);
+  this->start();
+  ASSERT_TRUE(App.run_until([&]() { return this->component_.throughput_.sessions == 1; }, 60000));
+  ASSERT_EQ(sum.published.size(), 1u);
+  this->meter_.remove_value("CURRE");
+  ASSERT_TRUE(App.run_until([&]() { return this->component_.throughput_.sessions == 3; }, 60000));
+
+  EXPECT_EQ(voltage->published.size(), 3u);
+  EXPECT_EQ(sum.published.size(), 1u);
+}
+
+TEST_F(PublishTest, RestoredValuesAreFlaggedUntilRead) {
+  float before_reboot = 231.0f;
+  global_preferences->make_preference<float>(fnv1_hash("energomera_iec//VOLTA()/1/0")).save(&before_reboot);
+  binary_sensor::BinarySensor restored;
+  auto *voltage = this->sensors_.add(&this->component_, "VOLTA()");
+  this->component_.set_restore_value(true);
+  this->component_.set_restored_sensor(&restored);
+  this->start();
+  ASSERT_EQ(voltage->published.size(), 1u);
+  EXPECT_TRUE(restored.state);
+
+  ASSERT_TRUE(App.run_until([&]() { return this->component_.throughput_.sessions == 1; }, 60000));
+  EXPECT_EQ(voltage->published.size(), 2u);
+  EXPECT_FALSE(restored.state);
+}
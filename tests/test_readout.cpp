@@ -0,0 +1,120 @@
+// Data readout mode and what is read in programming mode after it
+#include <gtest/gtest.h>
+
+#include "harness.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+class ReadoutTest : public ::testing::Test {
+ protected:
+  SimUart uart_;
+  SimMeter meter_{"", SimMeter::CE303};
+  TestComponent component_;
+  SensorSet sensors_;
+
+  void SetUp() override {
+    host::reset();
+    this->uart_.add_meter(&this->meter_);
+    this->component_.set_uart_parent(&this->uart_);
+    this->component_.set_update_interval(30000);
+    this->component_.set_readout(true);
+  }
+  void run_sessions(uint32_t sessions) {
+    App.register_component(&this->component_);
+    App.setup();
+    ASSERT_TRUE(App.run_until([&]() { return this->component_.throughput_.sessions == sessions; }, 120000));
+  }
+};
+
+TEST_F(ReadoutTest, CoveredRequestsAreNotReadAgain) {
+  this->sensors_.add(&this->component_, "ET0PE()", 2);
+  this->sensors_.add(&this->component_, "VOLTA()", 3);
+  this->run_sessions(2);
+
+  EXPECT_EQ(this->meter_.get_stats().readouts, 2u);
+  EXPECT_EQ(this->meter_.get_stats().requests, 0u);
+  for (const auto &sensor : this->sensors_.all())
+    EXPECT_EQ(sensor->published.size(), 2u) << sensor->get_name();
+  // each value of CE303 comes on its own line, with the name repeated
+  EXPECT_FLOAT_EQ(this->sensors_.all()[0]->state, 7956.98f);
+}
+
+TEST_F(ReadoutTest, ReadoutComesAtTheSpeedOfTheIdentification) {
+  SimUart uart;
+  uart.set_baud_rate(2400);
+  SimMeter meter("", SimMeter::CE303, 2400);
+  uart.add_meter(&meter);
+  TestComponent component;
+  component.set_uart_parent(&uart);
+  component.set_update_interval(30000);
+  component.set_readout(true);
+  component.set_baud_rate_handshake(2400);
+  SensorSet sensors;
+  auto *voltage = sensors.add(&component, "VOLTA()", 3);
+  App.register_component(&component);
+  App.setup();
+
+  ASSERT_TRUE(App.run_until([&]() { return component.throughput_.sessions == 1; }, 60000));
+  EXPECT_EQ(meter.get_stats().readouts, 1u);
+  EXPECT_EQ(component.baud_rate_, 9600u);
+  EXPECT_FLOAT_EQ(voltage->state, 228.40f);
+}
+
+TEST_F(ReadoutTest, MultiValueDatasetsOfCe102m) {
+  SimUart uart;
+  SimMeter meter("", SimMeter::CE102M);
+  uart.add_meter(&meter);
+  TestComponent component;
+  component.set_uart_parent(&uart);
+  component.set_update_interval(30000);
+  component.set_readout(true);
+  SensorSet sensors;
+  auto *t2 = sensors.add(&component, "ET0PE()", 2);
+  auto *t3 = sensors.add(&component, "ET0PE()", 3);
+  App.register_component(&component);
+  App.setup();
+  ASSERT_TRUE(App.run_until([&]() { return component.throughput_.sessions == 1; }, 60000));
+
+  EXPECT_EQ(meter.get_stats().requests, 0u);
+  EXPECT_FLOAT_EQ(t2->state, 7956.98f);
+  EXPECT_FLOAT_EQ(t3->state, 7964.40f);
+}
+
+TEST_F(ReadoutTest, BrokenReadoutIsReadAgainInProgrammingMode) {
+  this->meter_.set_readout_bcc_error(true);
+  this->sensors_.add(&this->component_, "ET0PE()", 2);
+  this->sensors_.add(&this->component_, "VOLTA()", 3);
+  this->sensors_.add(&this->component_, "FREQU()");
+  this->run_sessions(1);
+
+  // nothing from the block is trusted
+  EXPECT_EQ(this->meter_.get_stats().readouts, 1u);
+  EXPECT_EQ(this->meter_.get_stats().requests, 3u);
+  for (const auto &sensor : this->sensors_.all())
+    EXPECT_EQ(sensor->published.size(), 1u) << sensor->get_name();
+}
+
+TEST_F(ReadoutTest, MeterIsNotReadOutWhenProgrammingModeIsNeededAnyway) {
+  this->sensors_.add(&this->component_, "VOLTA()", 1);
+  this->sensors_.add_text(&this->component_, "TIME_()");
+  this->run_sessions(3);
+
+  // TIME_ is not in the readout, after the first session the meter is read in one go
+  EXPECT_EQ(this->meter_.get_stats().readouts, 1u);
+  EXPECT_EQ(this->meter_.get_stats().sign_ons, 4u);
+  EXPECT_EQ(this->component_.meters_[0].readout_misses, 1u);
+  EXPECT_EQ(this->sensors_.all()[0]->published.size(), 3u);
+}
+
+TEST_F(ReadoutTest, ReadoutThatMissedRequestsIsTriedAgainLater) {
+  this->sensors_.add(&this->component_, "VOLTA()", 1);
+  this->sensors_.add_text(&this->component_, "TIME_()");
+  App.register_component(&this->component_);
+  App.setup();
+  // readout in the first session, programming mode only for the next 49
+  ASSERT_TRUE(App.run_until([&]() { return this->component_.throughput_.sessions == 50; }, 50 * 30000));
+  EXPECT_EQ(this->meter_.get_stats().readouts, 1u);
+  ASSERT_TRUE(App.run_until([&]() { return this->component_.throughput_.sessions == 51; }, 60000));
+  EXPECT_EQ(this->meter_.get_stats().readouts, 2u);
+}
@@ -0,0 +1,106 @@
+// Whole sessions against simulated meters on a simulated line
+#include <gtest/gtest.h>
+
+#include "harness.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+class SessionTest : public ::testing::Test {
+ protected:
+  void SetUp() override { host::reset(); }
+};
+
+TEST_F(SessionTest, ReadsAllSensorsOfCe102m) {
+  SimUart uart;
+  SimMeter meter("", SimMeter::CE102M);
+  uart.add_meter(&meter);
+
+  TestComponent component;
+  component.set_uart_parent(&uart);
+  component.set_update_interval(30000);
+  SensorSet sensors;
+  sensors.add(&component, CE102M_CONFIG);
+  App.register_component(&component);
+  App.setup();
+
+  ASSERT_TRUE(App.run_until([&]() { return component.throughput_.sessions == 1; }, 60000));
+  for (const auto &sensor : sensors.all())
+    EXPECT_TRUE(sensor->has_state()) << sensor->get_name();
+  for (const auto &sensor : sensors.all_text())
+    EXPECT_TRUE(sensor->has_state()) << sensor->get_name();
+  EXPECT_FLOAT_EQ(sensors.all()[0]->state, 15921.38f);
+  EXPECT_FLOAT_EQ(sensors.all()[2]->state, 7964.40f);
+  EXPECT_EQ(meter.get_stats().sign_ons, 1u);
+}
+
+TEST_F(SessionTest, LineSlowerThan9600) {
+  // handshake and session at 300 baud: "<ACK>001" keeps the meter there, and a 30 byte reply takes a second
+  SimUart uart;
+  uart.set_baud_rate(300);
+  SimMeter meter("", SimMeter::CE102M, 300);
+  uart.add_meter(&meter);
+
+  TestComponent component;
+  component.set_uart_parent(&uart);
+  component.set_baud_rate_handshake(300);
+  component.set_baud_rate(300);
+  component.set_update_interval(60000);
+  SensorSet sensors;
+  auto *energy = sensors.add(&component, "ET0PE()", 3);
+  App.register_component(&component);
+  App.setup();
+
+  ASSERT_TRUE(App.run_until([&]() { return component.throughput_.sessions == 1; }, 60000));
+  EXPECT_FLOAT_EQ(energy->state, 7964.40f);
+  EXPECT_EQ(meter.get_baud_rate(), 300u);
+  EXPECT_EQ(component.meters_[0].stats.invalid_frames_, 0u);
+}
+
+TEST_F(SessionTest, UnknownModelGetsTheSpeedItReports) {
+  // no profile for it, the identification still says 4800 at most
+  const SimMeter::Model model{"/EKT4CE999v01", false, 1, 60, 3000};
+  SimUart uart;
+  uart.set_baud_rate(2400);
+  SimMeter meter("", model, 2400);
+  uart.add_meter(&meter);
+
+  TestComponent component;
+  component.set_uart_parent(&uart);
+  component.set_baud_rate_handshake(2400);
+  component.set_update_interval(60000);
+  SensorSet sensors;
+  auto *voltage = sensors.add(&component, "VOLTA()");
+  App.register_component(&component);
+  App.setup();
+
+  ASSERT_TRUE(App.run_until([&]() { return component.throughput_.sessions == 1; }, 60000));
+  EXPECT_EQ(component.meters_[0].profile, nullptr);
+  EXPECT_EQ(component.baud_rate_, 4800u);
+  EXPECT_EQ(voltage->published.size(), 1u);
+}
+
+TEST_F(SessionTest, BurstRequestedMidSessionWaitsForIt) {
+  SimUart uart;
+  SimMeter meter("", SimMeter::CE102M);
+  uart.add_meter(&meter);
+
+  TestComponent component;
+  component.set_uart_parent(&uart);
+  component.set_update_interval(30000);
+  SensorSet sensors;
+  sensors.add(&component, CE102M_CONFIG);
+  App.register_component(&component);
+  App.setup();
+
+  ASSERT_TRUE(App.run_until([&]() { return meter.get_stats().requests == 1; }, 60000));
+  component.start_burst({"VOLTA"}, 5000, 1000);
+  EXPECT_FALSE(component.is_burst_active());
+  // the regular cycle reads everything, then the burst takes over
+  ASSERT_TRUE(App.run_until([&]() { return component.is_burst_active(); }, 10000));
+  EXPECT_EQ(component.throughput_.sessions, 1u);
+  for (const auto &sensor : sensors.all())
+    EXPECT_TRUE(sensor->has_state()) << sensor->get_name();
+  for (const auto &sensor : sensors.all_text())
+    EXPECT_TRUE(sensor->has_state()) << sensor->get_name();
+}
@@ -0,0 +1,168 @@
+// TCP transport against a gateway on a local socket, the meter behind it is simulated
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "harness.h"
+
+using namespace esphome;
+using namespace esphome::host;
+using energomera_iec::EnergomeraIecTcpTransport;
+
+// Transparent RS485-to-TCP gateway: bytes go to the meter, replies come back right away
+class SimGateway {
+ public:
+  explicit SimGateway(SimMeter *meter) : meter_(meter) {
+    this->server_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(this->server_, (struct sockaddr *) &addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    ::getsockname(this->server_, (struct sockaddr *) &addr, &len);
+    this->port_ = ntohs(addr.sin_port);
+    ::listen(this->server_, 4);
+    fcntl(this->server_, F_SETFL, O_NONBLOCK);
+  }
+  ~SimGateway() {
+    if (this->client_ >= 0)
+      ::close(this->client_);
+    ::close(this->server_);
+  }
+
+  uint16_t get_port() const { return this->port_; }
+  uint32_t get_connections() const { return this->connections_; }
+
+  void serve() {
+    int fd = ::accept(this->server_, nullptr, nullptr);
+    if (fd >= 0) {
+      if (this->client_ >= 0)
+        ::close(this->client_);
+      this->client_ = fd;
+      this->connections_++;
+      fcntl(fd, F_SETFL, O_NONBLOCK);
+    }
+    if (this->client_ < 0)
+      return;
+    uint8_t buf[128];
+    ssize_t len = ::read(this->client_, buf, sizeof(buf));
+    for (ssize_t i = 0; i < len; i++) {
+      auto reply = this->meter_->on_byte(buf[i], now_us());
+      if (!reply.bytes.empty())
+        ::send(this->client_, reply.bytes.data(), reply.bytes.size(), MSG_NOSIGNAL);
+    }
+  }
+
+ protected:
+  SimMeter *meter_;
+  int server_;
+  int client_{-1};
+  uint16_t port_;
+  uint32_t connections_{0};
+};
+
+// a port nobody listens on
+static uint16_t closed_port() {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ::bind(fd, (struct sockaddr *) &addr, sizeof(addr));
+  socklen_t len = sizeof(addr);
+  ::getsockname(fd, (struct sockaddr *) &addr, &len);
+  ::close(fd);
+  return ntohs(addr.sin_port);
+}
+
+class TcpTest : public ::testing::Test {
+ protected:
+  void SetUp() override { host::reset(); }
+
+  template<typename Fn> bool run_until(SimGateway *gateway, Fn &&condition, uint32_t timeout_ms) {
+    return App.run_until(
+        [&]() {
+          if (gateway != nullptr)
+            gateway->serve();
+          return condition();
+        },
+        timeout_ms);
+  }
+};
+
+TEST_F(TcpTest, FirstPollConnectsAndReads) {
+  SimMeter meter("", SimMeter::CE303);
+  SimGateway gateway(&meter);
+
+  TestComponent component;
+  component.set_tcp_transport("127.0.0.1", gateway.get_port(), 200);
+  component.set_update_interval(30000);
+  SensorSet sensors;
+  auto *energy = sensors.add(&component, "ET0PE()");
+  App.register_component(&component);
+  App.setup();
+
+  // the connect happens within the first poll, which must not be lost to it
+  ASSERT_TRUE(run_until(&gateway, [&]() { return component.throughput_.sessions == 1; }, 10000));
+  EXPECT_EQ(gateway.get_connections(), 1u);
+  EXPECT_EQ(component.meters_[0].stats.failures_, 0);
+  EXPECT_FLOAT_EQ(energy->state, 15921.38f);
+}
+
+TEST_F(TcpTest, RefusedConnectionFailsThePollRightAway) {
+  TestComponent component;
+  component.set_tcp_transport("127.0.0.1", closed_port(), 200);
+  component.set_update_interval(30000);
+  SensorSet sensors;
+  sensors.add(&component, "ET0PE()");
+  App.register_component(&component);
+  App.setup();
+
+  // boot is over in about half a second, SO_ERROR reports the refusal long before the connect timeout
+  ASSERT_TRUE(run_until(nullptr, [&]() { return component.meters_[0].stats.failures_ == 1; }, 2000));
+  EXPECT_TRUE(component.is_idle());
+  EXPECT_FALSE(component.transport_->is_connecting());
+}
+
+TEST_F(TcpTest, ConnectionsToOneGatewayShareTheBus) {
+  EnergomeraIecTcpTransport a("192.168.1.10", 4001, 200);
+  EnergomeraIecTcpTransport b("192.168.1.10", 4001, 200);
+  EnergomeraIecTcpTransport c("192.168.1.10", 4002, 200);
+  EnergomeraIecTcpTransport d("192.168.1.11", 4001, 200);
+  EXPECT_EQ(a.bus_id(), b.bus_id());
+  EXPECT_NE(a.bus_id(), c.bus_id());
+  EXPECT_NE(a.bus_id(), d.bus_id());
+}
+
+TEST_F(TcpTest, InstancesOnOneGatewayTakeTurns) {
+  SimMeter meter("1001", SimMeter::CE303);
+  SimGateway gateway(&meter);
+
+  // two components, one gateway port: they must not talk over each other
+  TestComponent first;
+  TestComponent second;
+  first.set_tcp_transport("127.0.0.1", gateway.get_port(), 200);
+  second.set_tcp_transport("127.0.0.1", gateway.get_port(), 200);
+  first.set_update_interval(30000);
+  second.set_update_interval(30000);
+  first.add_meter("1001");
+  second.add_meter("1001");
+  SensorSet sensors;
+  sensors.add(&first, "ET0PE()", 1, "1001");
+  sensors.add(&second, "VOLTA()", 1, "1001");
+  App.register_component(&first);
+  App.register_component(&second);
+  App.setup();
+  EXPECT_EQ(first.transport_->bus_id(), second.transport_->bus_id());
+
+  bool overlapped = false;
+  ASSERT_TRUE(run_until(
+      &gateway,
+      [&]() {
+        overlapped = overlapped || (first.throughput_.locked && second.throughput_.locked);
+        return first.throughput_.sessions >= 1 && second.throughput_.sessions >= 1;
+      },
+      70000));
+  EXPECT_FALSE(overlapped);
+}